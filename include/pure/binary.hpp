@@ -0,0 +1,541 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/types/var.hpp>
+#include <pure/types/immediate.hpp>
+#include <pure/object/basic_string.hpp>
+#include <pure/object/basic_string_view.hpp>
+#include <pure/object/persistent_vector.hpp>
+#include <pure/object/persistent_map.hpp>
+#include <pure/support/enumerator.hpp>
+#include <pure/support/utf8.hpp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ Compact binary encoding of values for caching and IPC. Every value starts with a tag byte, followed by
+ - nothing for Nil, False and True,
+ - a zigzag encoded varint for Int,
+ - 8 little endian bytes for Double,
+ - the code point as varint for Char,
+ - the number of bytes as varint and the utf8 bytes without terminator for String,
+ - the number of items as varint, the number of bytes of the body as varint and the body for Vector and Map. The body
+   of a map holds alternating keys and values, and no key occurs twice.
+ Containers store the size of their body, so a reader can skip them in constant time.
+ */
+namespace pure::binary {
+	enum class Tag : uint8_t { Nil, False, True, Int, Double, Char, String, Vector, Map };
+
+	/**
+	 Maximum number of containers nested in each other, which are decoded. Deeper input throws instead of overflowing
+	 the stack.
+	 */
+	constexpr intptr_t max_depth = 256;
+
+	namespace detail {
+		constexpr uint64_t zigzag (int64_t x) {
+			return (static_cast<uint64_t> (x) << 1) ^ static_cast<uint64_t> (x >> 63);
+		}
+
+		constexpr int64_t unzigzag (uint64_t x) {
+			return static_cast<int64_t> (x >> 1) ^ -static_cast<int64_t> (x & 1);
+		}
+
+		constexpr intptr_t varint_size (uint64_t x) {
+			intptr_t n = 1;
+			for (; x >= 0x80; x >>= 7) ++n;
+			return n;
+		}
+
+		inline uint64_t read_varint (const char*& p, const char* end) {
+			uint64_t result = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (p == end) throw operation_not_supported ();
+				auto byte = static_cast<uint8_t> (*p++);
+				result |= static_cast<uint64_t> (byte & 0x7F) << shift;
+				if (!(byte & 0x80)) return result;
+			}
+			throw operation_not_supported ();
+		}
+
+		// Reads the 8 little endian bytes of a Double.
+		inline uint64_t read_fixed_8 (const char* p) {
+			uint64_t result = 0;
+			for (int i = 0; i < 8; ++i) result |= static_cast<uint64_t> (static_cast<uint8_t> (p[i])) << (8 * i);
+			return result;
+		}
+
+		// Reads a varint, which has to be a size of at most the number of bytes left after it.
+		inline intptr_t read_size (const char*& p, const char* end) {
+			auto size = read_varint (p, end);
+			if (size > static_cast<uint64_t> (end - p)) throw operation_not_supported ();
+			return static_cast<intptr_t> (size);
+		}
+
+		template<typename T>
+		Tag tag_of (const T& self) {
+			auto category = pure::category_id (self);
+			if (category == Nil.id) return Tag::Nil;
+			if (category == False.id) return Tag::False;
+			if (category == True.id) return Tag::True;
+			if (category == Int.id) return Tag::Int;
+			if (category == Double.id) return Tag::Double;
+			if (category == Character.id) return Tag::Char;
+			if (category == String.id) return Tag::String;
+			if (category == Any_Vector.id) return Tag::Vector;
+			if (category == Any_Function.id) return Tag::Map;
+			throw operation_not_supported ();
+		}
+
+		template<typename To, typename T>
+		To scalar_value (const T& self) {
+			if constexpr (std::is_convertible_v<const T&, To>) return static_cast<To> (self);
+			else throw operation_not_supported ();
+		}
+
+		template<typename T>
+		std::pair<const char*, intptr_t> string_value (const T& self) {
+			if constexpr (Trait_CString<T>::implemented) {
+				return {pure::raw_cstring (self), pure::raw_cstring_length (self)};
+			}
+			else throw operation_not_supported ();
+		}
+
+		struct container_size {
+			intptr_t count;
+			intptr_t num_bytes;
+			// Index into layout_t::children or -1, if the container is enumerated again for writing.
+			intptr_t children;
+		};
+
+		/**
+		 Sizes of all containers in a value in the order in which they are written. Containers, whose enumerators
+		 don't know their size, like filter or generator, may be single pass or compute their items on every
+		 enumeration. Their items are enumerated once and kept in children.
+		 */
+		struct layout_t {
+			std::vector<container_size> sizes;
+			std::vector<std::vector<var>> children;
+		};
+
+		/**
+		 Calls fn for every item of a vector, or for every key and value of a map, and returns the number of items or
+		 entries.
+		 */
+		template<typename Enumerator, typename Fn>
+		intptr_t for_each_child (Enumerator&& enumerator, Tag tag, Fn&& fn) {
+			intptr_t count = 0;
+			for (; !enumerator.empty (); enumerator.next (), ++count) {
+				auto&& item = enumerator.read ();
+				if (tag != Tag::Map) fn (item);
+				else if constexpr (Trait_Enumerable<std::decay_t<decltype (item)>>::implemented) {
+					fn (pure::first (item));
+					fn (pure::second (item));
+				}
+				else throw operation_not_supported ();
+			}
+			return count;
+		}
+
+		/**
+		 Returns the number of bytes needed to encode self and appends the sizes of all containers in self to layout.
+		 */
+		template<typename T>
+		intptr_t measure (const T& self, layout_t& layout) {
+			auto tag = tag_of (self);
+			switch (tag) {
+				case Tag::Int : return 1 + varint_size (zigzag (scalar_value<int64_t> (self)));
+				case Tag::Double : return 9;
+				case Tag::Char : return 1 + varint_size (scalar_value<char32_t> (self));
+				case Tag::String : {
+					auto length = string_value (self).second;
+					return 1 + varint_size (length) + length;
+				}
+				case Tag::Vector :
+				case Tag::Map : {
+					if constexpr (Trait_Enumerable<T>::implemented) {
+						auto slot = layout.sizes.size ();
+						layout.sizes.emplace_back ();
+						intptr_t num_bytes = 0;
+						auto add = [&] (const auto& child) { num_bytes += measure (child, layout); };
+						auto enumerator = pure::enumerate (self);
+						intptr_t count;
+						intptr_t children = -1;
+						if (enumerator.has_size ()) count = for_each_child (enumerator, tag, add);
+						else {
+							std::vector<var> items;
+							count = for_each_child (enumerator, tag, [&] (const auto& child) {
+								items.emplace_back (child);
+							});
+							for (const auto& item : items) add (item);
+							children = layout.children.size ();
+							layout.children.push_back (std::move (items));
+						}
+						layout.sizes[slot] = {count, num_bytes, children};
+						return 1 + varint_size (count) + varint_size (num_bytes) + num_bytes;
+					}
+					else throw operation_not_supported ();
+				}
+				default : return 1;
+			}
+		}
+
+		/**
+		 Buffers small writes, so that streams only see a few large writes.
+		 */
+		template<typename Stream>
+		struct output {
+			Stream& stream;
+			uint8_t buffer[4096];
+			intptr_t used = 0;
+			bool ok = true;
+
+			output (Stream& stream) : stream {stream} {}
+
+			void flush () {
+				if (used) ok &= IO::write_raw_bytes (stream, buffer, used);
+				used = 0;
+			}
+
+			void write_byte (uint8_t byte) {
+				if (used == sizeof (buffer)) flush ();
+				buffer[used++] = byte;
+			}
+
+			void write_bytes (const char* data, intptr_t num_bytes) {
+				if (num_bytes > intptr_t (sizeof (buffer)) - used) {
+					flush ();
+					if (num_bytes > intptr_t (sizeof (buffer))) {
+						ok &= IO::write_raw_bytes (stream, reinterpret_cast<const uint8_t*> (data), num_bytes);
+						return;
+					}
+				}
+				std::memcpy (buffer + used, data, num_bytes);
+				used += num_bytes;
+			}
+
+			void write_varint (uint64_t x) {
+				for (; x >= 0x80; x >>= 7) write_byte (static_cast<uint8_t> (x) | 0x80);
+				write_byte (static_cast<uint8_t> (x));
+			}
+		};
+
+		template<typename Stream, typename T>
+		void write (output<Stream>& out, const T& self, const layout_t& layout, intptr_t& next_size) {
+			auto tag = tag_of (self);
+			out.write_byte (static_cast<uint8_t> (tag));
+			switch (tag) {
+				case Tag::Int : return out.write_varint (zigzag (scalar_value<int64_t> (self)));
+				case Tag::Double : {
+					auto value = scalar_value<double> (self);
+					uint64_t bits = 0;
+					std::memcpy (&bits, &value, sizeof (bits));
+					for (int i = 0; i < 8; ++i) out.write_byte (static_cast<uint8_t> (bits >> (8 * i)));
+					return;
+				}
+				case Tag::Char : return out.write_varint (scalar_value<char32_t> (self));
+				case Tag::String : {
+					auto [str, length] = string_value (self);
+					out.write_varint (length);
+					return out.write_bytes (str, length);
+				}
+				case Tag::Vector :
+				case Tag::Map : {
+					auto size = layout.sizes[next_size++];
+					out.write_varint (size.count);
+					out.write_varint (size.num_bytes);
+					auto write_child = [&] (const auto& child) { write (out, child, layout, next_size); };
+					if (size.children >= 0) {
+						for (const auto& child : layout.children[size.children]) write_child (child);
+					}
+					else if constexpr (Trait_Enumerable<T>::implemented) {
+						// A container, which changed since it was measured, can't be written consistently.
+						if (for_each_child (pure::enumerate (self), tag, write_child) != size.count) out.ok = false;
+					}
+					return;
+				}
+				default : return;
+			}
+		}
+	}
+
+	/**
+	 Non-owning view of an encoded value inside a buffer, which has to outlive the view. Only the parts needed by an
+	 accessor are decoded, so large vectors and maps can be inspected in place. Every read is checked against the end
+	 of the buffer and malformed input throws operation_not_supported.
+	 */
+	struct view {
+		const char* data;
+		const char* end;
+
+		view (const char* data, intptr_t num_bytes) : data {data}, end {data + num_bytes} {}
+
+		Tag tag () const {
+			if (data >= end) throw operation_not_supported ();
+			auto tag = static_cast<uint8_t> (*data);
+			if (tag > static_cast<uint8_t> (Tag::Map)) throw operation_not_supported ();
+			return static_cast<Tag> (tag);
+		}
+
+		int64_t get_int () const {
+			auto p = payload (Tag::Int);
+			return detail::unzigzag (detail::read_varint (p, end));
+		}
+
+		double get_double () const {
+			auto p = payload (Tag::Double);
+			if (end - p < 8) throw operation_not_supported ();
+			auto bits = detail::read_fixed_8 (p);
+			double result;
+			std::memcpy (&result, &bits, sizeof (result));
+			return result;
+		}
+
+		char32_t get_char () const {
+			auto p = payload (Tag::Char);
+			auto c = detail::read_varint (p, end);
+			if (c > 0x10FFFF) throw operation_not_supported ();
+			return static_cast<char32_t> (c);
+		}
+
+		/**
+		 Returns the utf8 bytes of a string, which aren't null-terminated, and stores their number in length. Throws,
+		 if the bytes aren't valid utf8.
+		 */
+		const char* get_string (intptr_t& length) const {
+			auto str = string_bytes (length);
+			if (!utf8::valid (str, length)) throw operation_not_supported ();
+			return str;
+		}
+
+		/**
+		 Returns a string, which refers to the bytes in the buffer instead of copying them.
+		 */
+		immediate<Basic::String_View> get_string_view () const {
+			intptr_t length;
+			auto str = get_string (length);
+			return {str, length};
+		}
+
+		/**
+		 Returns the number of items of a vector or the number of entries of a map.
+		 */
+		intptr_t count () const { return container ().count; }
+
+		/**
+		 Returns the number of bytes of the encoded value.
+		 */
+		intptr_t num_bytes () const {
+			auto p = data + 1;
+			switch (tag ()) {
+				case Tag::Int :
+				case Tag::Char : detail::read_varint (p, end);
+					return p - data;
+				case Tag::Double : if (end - p < 8) throw operation_not_supported ();
+					return 9;
+				case Tag::String : {
+					intptr_t length;
+					return string_bytes (length) + length - data;
+				}
+				case Tag::Vector :
+				case Tag::Map : {
+					auto body = container ();
+					return body.begin + body.num_bytes - data;
+				}
+				default : return 1;
+			}
+		}
+
+		/**
+		 Enumerates the items of a vector, or the keys and values of a map in alternating order.
+		 */
+		struct enumerator : enumerator_base<view> {
+			const char* pos;
+			const char* end;
+			intptr_t remaining;
+
+			enumerator (const char* begin, const char* end, intptr_t remaining) :
+					pos {begin}, end {end}, remaining {remaining} {}
+
+			void next () {
+				pos += read ().num_bytes ();
+				--remaining;
+			}
+
+			bool empty () const noexcept { return remaining == 0; }
+
+			view read () const { return {pos, end - pos}; }
+			view move () const { return read (); }
+
+			bool has_size () const noexcept { return true; }
+			intptr_t size () const noexcept { return remaining; }
+		};
+
+		enumerator enumerate () const {
+			auto body = container ();
+			auto num_children = tag () == Tag::Map ? 2 * body.count : body.count;
+			return {body.begin, body.begin + body.num_bytes, num_children};
+		}
+
+		/**
+		 Returns the n-th item of a vector. Items are skipped one by one, but containers among them in constant time.
+		 */
+		view nth (intptr_t n) const {
+			if (tag () != Tag::Vector || n < 0 || n >= count ()) throw operation_not_supported ();
+			auto enumerator = enumerate ();
+			for (; n > 0; --n) enumerator.next ();
+			return enumerator.read ();
+		}
+
+		/**
+		 Returns true, if the encoded value equals key according to pure::equal. Scalars and strings are compared
+		 without decoding.
+		 */
+		bool equals (const var& key) const {
+			switch (tag ()) {
+				case Tag::String : {
+					if (pure::category_id (key) != String.id) return false;
+					// Bytes, which are equal to a valid string, are valid themselves.
+					intptr_t length;
+					auto str = string_bytes (length);
+					return length == pure::raw_cstring_length (key) &&
+						   std::memcmp (str, pure::raw_cstring (key), length) == 0;
+				}
+				case Tag::Vector :
+				case Tag::Map : return pure::equal (key, decode ());
+				default : return pure::equal (key, decode_scalar ());
+			}
+		}
+
+		/**
+		 Searches the keys of a map for key. Stores the value in result, unless result is nullptr, and returns true if
+		 it was found. The keys are searched linearly.
+		 */
+		bool lookup (const var& key, view* result) const {
+			if (tag () != Tag::Map) throw operation_not_supported ();
+			for (auto enumerator = enumerate (); !enumerator.empty (); enumerator.next ()) {
+				bool found = enumerator.read ().equals (key);
+				enumerator.next ();
+				if (found) {
+					if (result) *result = enumerator.read ();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 Decodes the value into var. Vectors become Persistent::Vector<var> and maps Persistent::Map<var, var>. Throws,
+		 if containers are nested deeper than max_depth.
+		 */
+		var decode () const { return decode_nested (0); }
+
+	private:
+		struct body_t {
+			intptr_t count;
+			intptr_t num_bytes;
+			const char* begin;
+		};
+
+		const char* payload (Tag expected) const {
+			if (tag () != expected) throw operation_not_supported ();
+			return data + 1;
+		}
+
+		const char* string_bytes (intptr_t& length) const {
+			auto p = payload (Tag::String);
+			length = detail::read_size (p, end);
+			return p;
+		}
+
+		body_t container () const {
+			auto t = tag ();
+			if (t != Tag::Vector && t != Tag::Map) throw operation_not_supported ();
+			auto p = data + 1;
+			auto count = detail::read_size (p, end);
+			auto num_bytes = detail::read_size (p, end);
+			// Every item takes at least one byte.
+			if ((t == Tag::Map ? 2 * count : count) > num_bytes) throw operation_not_supported ();
+			return {count, num_bytes, p};
+		}
+
+		var decode_nested (intptr_t depth) const {
+			switch (tag ()) {
+				case Tag::String : {
+					intptr_t length;
+					auto str = get_string (length);
+					return var {Basic::String::create_from_cstring (Basic::String::capacity_needed_for_length (length),
+																	str, length)};
+				}
+				case Tag::Vector : {
+					if (depth >= max_depth) throw operation_not_supported ();
+					auto result = Persistent::Vector<var>::vector_type {}.transient ();
+					for (auto enumerator = enumerate (); !enumerator.empty (); enumerator.next ()) {
+						result.push_back (enumerator.read ().decode_nested (depth + 1));
+					}
+					return immediate<Persistent::Vector<var>> {result.persistent ()};
+				}
+				case Tag::Map : {
+					if (depth >= max_depth) throw operation_not_supported ();
+					Persistent::Map<var, var>::map_type result;
+					for (auto enumerator = enumerate (); !enumerator.empty (); enumerator.next ()) {
+						auto key = enumerator.read ().decode_nested (depth + 1);
+						enumerator.next ();
+						auto size = result.size ();
+						result = std::move (result).set (std::move (key), enumerator.read ().decode_nested (depth + 1));
+						// Duplicate keys are malformed.
+						if (result.size () == size) throw operation_not_supported ();
+					}
+					return immediate<Persistent::Map<var, var>> {std::move (result)};
+				}
+				default : return decode_scalar ();
+			}
+		}
+
+		var decode_scalar () const {
+			switch (tag ()) {
+				case Tag::Nil : return nullptr;
+				case Tag::False : return false;
+				case Tag::True : return true;
+				case Tag::Int : return get_int ();
+				case Tag::Double : return get_double ();
+				case Tag::Char : return get_char ();
+				default : throw operation_not_supported ();
+			}
+		}
+	};
+}
+
+namespace pure::IO {
+	/**
+	 Writes self to a stream in the format described in pure/binary.hpp. Works on atomic values, strings, vectors and
+	 enumerable functions, which are written as maps. Sequences without a known size, like generators, are enumerated
+	 only once.
+	 @return true on success, false if writing to the stream failed
+	 */
+	template<typename Stream, typename T>
+	bool write_binary (Stream&& stream, const T& self) {
+		binary::detail::layout_t layout;
+		binary::detail::measure (self, layout);
+		binary::detail::output<std::remove_reference_t<Stream>> out {stream};
+		intptr_t next_size = 0;
+		binary::detail::write (out, self, layout, next_size);
+		out.flush ();
+		if constexpr (std::is_same_v<type_class<Stream>, Type_Class::File_Stream>) {
+			// Files buffer writes, so errors may only show up when flushing.
+			out.ok &= std::fflush (stream) == 0 && !std::ferror (stream);
+		}
+		return out.ok;
+	}
+
+	/**
+	 Decodes a value written by write_binary, which has to take up exactly num_bytes bytes. Use binary::view to
+	 access parts of the value without decoding all of it.
+	 */
+	inline var read_binary (const char* data, intptr_t num_bytes) {
+		binary::view value {data, num_bytes};
+		if (value.num_bytes () != num_bytes) throw operation_not_supported ();
+		return value.decode ();
+	}
+}
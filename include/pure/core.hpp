@@ -48,18 +48,26 @@
 #include <pure/types/shared.hpp>
 #include <pure/types/weak.hpp>
 #include <pure/types/immediate.hpp>
+#include <pure/types/small.hpp>
 #include <pure/types/string.hpp>
 
 #include <pure/object/interface.hpp>
 #include <pure/object/boxed.hpp>
 #include <pure/object/basic_string.hpp>
+#include <pure/object/basic_string_view.hpp>
 #include <pure/object/basic_vector.hpp>
 #include <pure/object/persistent_vector.hpp>
 #include <pure/object/persistent_map.hpp>
+#include <pure/object/persistent_string.hpp>
 
 #include <pure/support/identifier.hpp>
 #include <pure/support/string_builder.hpp>
 
 #include <pure/constructors.hpp>
 #include <pure/functions.hpp>
+#include <pure/support/generator.hpp>
+#include <pure/pipeline.hpp>
+#include <pure/sort.hpp>
+#include <pure/binary.hpp>
+#include <pure/snapshot.hpp>
 #include <pure/macros.hpp>
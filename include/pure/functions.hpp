@@ -5,8 +5,21 @@
 #include <pure/traits.hpp>
 #include <pure/support/string_builder.hpp>
 #include <pure/types/var.hpp>
+#include <pure/types/maybe.hpp>
 #include <pure/support/file_stream.hpp>
+#include <pure/support/unicode.hpp>
+#include <pure/object/basic_vector.hpp>
+#include <pure/object/basic_string.hpp>
+#include <pure/object/basic_string_view.hpp>
+#include <pure/object/persistent_vector.hpp>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 namespace pure {
 	template<typename T>
@@ -16,7 +29,9 @@ namespace pure {
 	}
 
 	/**
-	 Returns a readable string representation of self. Works on atomic and enumerable values.
+	 Returns a readable string representation of self. Works on atomic and enumerable values. The result is a
+	 small<Basic::String, 127>, which holds representations of up to 127 bytes without allocating. It converts to
+	 unique<Basic::String> and var, which callers spelling out the former return type can keep using.
 	 */
 	template<typename T>
 	auto to_string (const T& self) {
@@ -25,6 +40,36 @@ namespace pure {
 		return result.finish ();
 	}
 
+	/**
+	 Returns true, if key is in the domain of the functional value self, i.e. if apply (self, key) wouldn't fail.
+	 Missing keys and out of bounds indices don't throw, so this is cheap even if most lookups miss.
+	 */
+	template<typename F, typename Key>
+	bool contains (const F& self, const Key& key) {
+		return Trait_Functional<F>::lookup (self, key, nullptr);
+	}
+
+	/**
+	 Returns apply (self, key), or default_value if key isn't in the domain of self.
+	 */
+	template<typename F, typename Key, typename Default>
+	var get (const F& self, const Key& key, Default&& default_value) {
+		var result;
+		if (Trait_Functional<F>::lookup (self, key, &result)) return result;
+		return std::forward<Default> (default_value);
+	}
+
+	/**
+	 Returns apply (self, key), or nullptr if key isn't in the domain of self. Values, which aren't held by pointer
+	 like integers, are boxed, so prefer get or contains for them.
+	 */
+	template<typename F, typename Key>
+	maybe<> find (const F& self, const Key& key) {
+		var result;
+		if (Trait_Functional<F>::lookup (self, key, &result)) return result;
+		return nullptr;
+	}
+
 	namespace IO {
 		/**
 		 Opens a file for reading or writing via std::fopen. The difference to std::fopen is that the returned FILE*
@@ -42,17 +87,72 @@ namespace pure {
 		}
 	}
 
+	namespace detail {
+		template<typename Transient, typename T>
+		void append_all_to (Transient& result, const T& value) {
+			for (auto enumerator = pure::enumerate (value); !enumerator.empty (); enumerator.next ())
+				result.push_back (var (enumerator.move ()));
+		}
+
+		/**
+		 Returns the Persistent::Vector<var> held by value or nullptr, if value holds any other kind of value.
+		 */
+		template<typename T>
+		const Persistent::Vector<var>* as_persistent_vector (const T& value) {
+			if constexpr (std::is_base_of_v<Persistent::Vector<var>, T>) return &value;
+			else if constexpr (std::is_base_of_v<var, T>) {
+				switch (value.tag ()) {
+					case Var_Tag_Pointer : return dynamic_cast<const Persistent::Vector<var>*> (value.operator-> ());
+					default : return nullptr;
+				}
+			}
+			else return nullptr;
+		}
+	}
+
 	/**
-	 Returns the concatenation of two values. Works on vectors and strings.
+	 Returns the concatenation of two or more values. Works on vectors and strings. The result has the kind of the
+	 first value. Strings are copied into a single allocation of the final length and a Persistent::Vector<var> is
+	 extended through a single transient, which shares its structure, instead of appending item by item.
 	 */
-	template<typename A, typename B>
-	auto concat (A&& lhs, B&& rhs) {
-		static_assert (Trait_Enumerable<B>::implemented);
-		var result = std::forward<A> (lhs);
-		for (auto enumerator = enumerate (rhs); !enumerator.empty (); enumerator.next ()) {
-			result = append (std::move (result), enumerator.read ());
+	template<typename A, typename B, typename... Rest>
+	var concat (A&& first, B&& second, Rest&& ... rest) {
+		static_assert (Trait_Enumerable<std::decay_t<B>>::implemented);
+		static_assert ((Trait_Enumerable<std::decay_t<Rest>>::implemented && ...));
+
+		if constexpr (Trait_CString<std::decay_t<A>>::implemented && Trait_CString<std::decay_t<B>>::implemented &&
+					  (Trait_CString<std::decay_t<Rest>>::implemented && ...)) {
+			if (String (first) && String (second) && (String (rest) && ...)) {
+				constexpr size_t count = sizeof... (Rest) + 2;
+				const char* cstrings[count] = {raw_cstring (first), raw_cstring (second), raw_cstring (rest)...};
+				intptr_t lengths[count] = {raw_cstring_length (first), raw_cstring_length (second),
+										   raw_cstring_length (rest)...};
+
+				intptr_t total_length = 0;
+				for (auto length : lengths) total_length += length;
+
+				auto result = Basic::String::create_empty (Basic::String::capacity_needed_for_length (total_length));
+				for (size_t i = 0; i < count; ++i) result->append_cstring (cstrings[i], lengths[i]);
+				return var {std::move (result)};
+			}
 		}
-		return std::move (result);
+
+		if (auto vector = detail::as_persistent_vector (first)) {
+			auto result = vector->self.transient ();
+			detail::append_all_to (result, second);
+			(detail::append_all_to (result, rest), ...);
+			return immediate<Persistent::Vector<var>> {result.persistent ()};
+		}
+
+		var result = std::forward<A> (first);
+		auto append_all = [&result] (const auto& value) {
+			for (auto enumerator = enumerate (value); !enumerator.empty (); enumerator.next ()) {
+				result = append (std::move (result), enumerator.move ());
+			}
+		};
+		append_all (second);
+		(append_all (rest), ...);
+		return result;
 	};
 
 	template<typename Source, typename Fn>
@@ -77,7 +177,7 @@ namespace pure {
 
 			void next () { source.next (); }
 			bool empty () const { return source.empty (); }
-			value_type read () {
+			value_type read () const {
 				return pure::apply (owner.map_fn, source.read ());
 			}
 
@@ -118,27 +218,26 @@ namespace pure {
 			Source_Enumerator source;
 
 			using value_type = typename Source_Enumerator::value_type;
+			using read_type = decltype (std::declval<const Source_Enumerator&> ().read ());
 
 			enumerator (const filter_sequence& owner) :
 					owner {owner},
-					source {pure::enumerate (owner.source)} {}
+					source {pure::enumerate (owner.source)} { skip (); }
 
-			void next () { source.next (); }
-			bool empty () const { return source.empty (); }
-			value_type read () {
-				while (!owner.filter_fn (source.read ()))
+			// Advances the source to the next accepted item, so that empty () is exact and the filter function is
+			// applied only once per item.
+			void skip () {
+				while (!source.empty () && !owner.filter_fn (source.read ()))
 					source.next ();
-				return source.read ();
 			}
 
-			value_type move () {
-				auto e = source.move ();
-				while (!owner.filter_fn (e)) {
-					source.next ();
-					e = source.move ();
-				}
-				return std::move (e);
+			void next () {
+				source.next ();
+				skip ();
 			}
+			bool empty () const { return source.empty (); }
+			read_type read () const { return source.read (); }
+			value_type move () { return source.move (); }
 
 			bool has_size () const { return false; }
 			intptr_t size () const { throw operation_not_supported (); }
@@ -158,6 +257,456 @@ namespace pure {
 		return filter_sequence<V, F> {std::forward<V> (vec), std::forward<F> (f)};
 	};
 
+	template<typename Source>
+	struct take_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		Source source;
+		intptr_t n;
+
+		template<typename S>
+		take_sequence (S&& source, intptr_t n) : source (std::forward<S> (source)), n {n} {}
+
+		struct enumerator {
+			Source_Enumerator source;
+			intptr_t remaining;
+
+			using value_type = typename Source_Enumerator::value_type;
+			using read_type = decltype (std::declval<const Source_Enumerator&> ().read ());
+
+			enumerator (const take_sequence& owner) :
+					source {pure::enumerate (owner.source)},
+					remaining {owner.n} {}
+
+			// The source isn't advanced past the n-th item, which could skip an unbounded number of items.
+			void next () {
+				if (--remaining > 0) source.next ();
+			}
+			bool empty () const { return remaining <= 0 || source.empty (); }
+			read_type read () const { return source.read (); }
+			value_type move () { return source.move (); }
+
+			bool has_size () const { return source.has_size (); }
+			intptr_t size () const { return std::min (std::max (remaining, intptr_t {0}), source.size ()); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector consisting of the first n items of vec, or all items if vec has fewer than n. The
+	 source is never enumerated past the n-th item, so take also works on infinite sequences.
+	 @param n Maximum number of items
+	 @param vec The source vector
+	 */
+	template<typename V>
+	auto take (intptr_t n, V&& vec) {
+		return take_sequence<V> {std::forward<V> (vec), n};
+	};
+
+	template<typename Source>
+	struct drop_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		Source source;
+		intptr_t n;
+
+		template<typename S>
+		drop_sequence (S&& source, intptr_t n) : source (std::forward<S> (source)), n {n} {}
+
+		struct enumerator {
+			Source_Enumerator source;
+
+			using value_type = typename Source_Enumerator::value_type;
+			using read_type = decltype (std::declval<const Source_Enumerator&> ().read ());
+
+			enumerator (const drop_sequence& owner) : source {pure::enumerate (owner.source)} {
+				for (intptr_t i = 0; i < owner.n && !source.empty (); ++i)
+					source.next ();
+			}
+
+			void next () { source.next (); }
+			bool empty () const { return source.empty (); }
+			read_type read () const { return source.read (); }
+			value_type move () { return source.move (); }
+
+			bool has_size () const { return source.has_size (); }
+			intptr_t size () const { return source.size (); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector consisting of all but the first n items of vec.
+	 @param n Number of items to skip
+	 @param vec The source vector
+	 */
+	template<typename V>
+	auto drop (intptr_t n, V&& vec) {
+		return drop_sequence<V> {std::forward<V> (vec), n};
+	};
+
+	template<typename Source, typename Fn>
+	struct take_while_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		Source source;
+		Fn predicate;
+
+		template<typename S, typename F>
+		take_while_sequence (S&& source, F&& predicate) : source (std::forward<S> (source)),
+														  predicate (std::forward<F> (predicate)) {}
+
+		struct enumerator {
+			const take_while_sequence& owner;
+			Source_Enumerator source;
+			bool done;
+
+			using value_type = typename Source_Enumerator::value_type;
+			using read_type = decltype (std::declval<const Source_Enumerator&> ().read ());
+
+			enumerator (const take_while_sequence& owner) :
+					owner {owner},
+					source {pure::enumerate (owner.source)},
+					done {!accepts_current ()} {}
+
+			bool accepts_current () const {
+				return !source.empty () && static_cast<bool> (pure::apply (owner.predicate, source.read ()));
+			}
+
+			void next () {
+				source.next ();
+				done = !accepts_current ();
+			}
+			bool empty () const { return done; }
+			read_type read () const { return source.read (); }
+			value_type move () { return source.move (); }
+
+			bool has_size () const { return false; }
+			intptr_t size () const { throw operation_not_supported (); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector consisting of the leading items of vec for which f returns true. Enumeration stops at
+	 the first item, which isn't accepted by f.
+	 @param f A set, i.e. boolean function of arity 1
+	 @param vec The source vector
+	 */
+	template<typename F, typename V>
+	auto take_while (F&& f, V&& vec) {
+		return take_while_sequence<V, F> {std::forward<V> (vec), std::forward<F> (f)};
+	};
+
+	template<typename Source>
+	struct chunk_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		Source source;
+		intptr_t n;
+
+		template<typename S>
+		chunk_sequence (S&& source, intptr_t n) : source (std::forward<S> (source)), n {n} {
+			if (n <= 0) throw operation_not_supported ();
+		}
+
+		struct enumerator {
+			using element_type = std::decay_t<typename Source_Enumerator::value_type>;
+			using value_type = immediate<Basic::Vector<element_type>>;
+
+			Source_Enumerator source;
+			intptr_t n;
+			std::vector<element_type> current;
+
+			enumerator (const chunk_sequence& owner) : source {pure::enumerate (owner.source)}, n {owner.n} {
+				fill ();
+			}
+
+			void fill () {
+				current.clear ();
+				current.reserve (n);
+				for (; !source.empty () && intptr_t (current.size ()) < n; source.next ())
+					current.emplace_back (source.move ());
+			}
+
+			void next () { fill (); }
+			bool empty () const { return current.empty (); }
+			value_type read () const { return {current}; }
+			value_type move () { return {std::move (current)}; }
+
+			bool has_size () const { return source.has_size (); }
+			intptr_t size () const { return (source.size () + n - 1) / n + (current.empty () ? 0 : 1); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector of vectors, each containing n consecutive items of vec. The last vector contains the
+	 remaining items and may be shorter than n.
+	 @param n Number of items per chunk
+	 @param vec The source vector
+	 */
+	template<typename V>
+	auto chunk (intptr_t n, V&& vec) {
+		return chunk_sequence<V> {std::forward<V> (vec), n};
+	};
+
+	template<typename Source, typename Fn>
+	struct partition_by_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		Source source;
+		Fn partition_fn;
+
+		template<typename S, typename F>
+		partition_by_sequence (S&& source, F&& partition_fn) : source (std::forward<S> (source)),
+															   partition_fn (std::forward<F> (partition_fn)) {}
+
+		struct enumerator {
+			using element_type = std::decay_t<typename Source_Enumerator::value_type>;
+			using value_type = immediate<Basic::Vector<element_type>>;
+
+			const partition_by_sequence& owner;
+			Source_Enumerator source;
+			std::vector<element_type> current;
+
+			enumerator (const partition_by_sequence& owner) :
+					owner {owner},
+					source {pure::enumerate (owner.source)} { fill (); }
+
+			void fill () {
+				current.clear ();
+				if (source.empty ()) return;
+				auto key = pure::apply (owner.partition_fn, source.read ());
+				current.emplace_back (source.move ());
+				for (source.next (); !source.empty (); source.next ()) {
+					if (!pure::equal (pure::apply (owner.partition_fn, source.read ()), key)) break;
+					current.emplace_back (source.move ());
+				}
+			}
+
+			void next () { fill (); }
+			bool empty () const { return current.empty (); }
+			value_type read () const { return {current}; }
+			value_type move () { return {std::move (current)}; }
+
+			bool has_size () const { return false; }
+			intptr_t size () const { throw operation_not_supported (); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector of vectors, splitting vec each time f returns a new value. Each vector contains a run of
+	 consecutive items, for which f returns equal values.
+	 @param f A function of arity 1
+	 @param vec The source vector
+	 */
+	template<typename F, typename V>
+	auto partition_by (F&& f, V&& vec) {
+		return partition_by_sequence<V, F> {std::forward<V> (vec), std::forward<F> (f)};
+	};
+
+	template<typename First, typename Second>
+	struct interleave_sequence : implements<Type_Class::Sequence> {
+
+		using First_Enumerator = decltype (pure::enumerate (std::declval<First> ()));
+		using Second_Enumerator = decltype (pure::enumerate (std::declval<Second> ()));
+		First first;
+		Second second;
+
+		template<typename A, typename B>
+		interleave_sequence (A&& first, B&& second) : first (std::forward<A> (first)),
+													  second (std::forward<B> (second)) {}
+
+		struct enumerator {
+			First_Enumerator first;
+			Second_Enumerator second;
+			bool on_second;
+
+			using value_type = unify_types<std::decay_t<typename First_Enumerator::value_type>,
+					std::decay_t<typename Second_Enumerator::value_type>>;
+
+			enumerator (const interleave_sequence& owner) :
+					first {pure::enumerate (owner.first)},
+					second {pure::enumerate (owner.second)},
+					on_second {false} {}
+
+			void next () {
+				if (on_second) {
+					first.next ();
+					second.next ();
+				}
+				on_second = !on_second;
+			}
+			bool empty () const { return first.empty () || second.empty (); }
+			value_type read () const { return on_second ? value_type (second.read ()) : value_type (first.read ()); }
+			value_type move () { return on_second ? value_type (second.move ()) : value_type (first.move ()); }
+
+			bool has_size () const { return first.has_size () && second.has_size (); }
+			intptr_t size () const { return 2 * std::min (first.size (), second.size ()) - (on_second ? 1 : 0); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector consisting of the first item of a, the first item of b, the second item of a and so
+	 on. Stops as soon as either a or b is exhausted.
+	 */
+	template<typename A, typename B>
+	auto interleave (A&& a, B&& b) {
+		return interleave_sequence<A, B> {std::forward<A> (a), std::forward<B> (b)};
+	};
+
+	struct range_sequence : implements<Type_Class::Sequence> {
+		intptr_t start;
+		intptr_t end;
+		intptr_t step;
+
+		struct enumerator : enumerator_base<intptr_t> {
+			intptr_t current;
+			intptr_t end;
+			intptr_t step;
+
+			enumerator (const range_sequence& owner) : current {owner.start}, end {owner.end}, step {owner.step} {}
+
+			// Distance to end and size of step, which can't overflow in uintptr_t.
+			uintptr_t distance () const noexcept {
+				return step > 0 ? uintptr_t (end) - uintptr_t (current) : uintptr_t (current) - uintptr_t (end);
+			}
+			uintptr_t stride () const noexcept { return step > 0 ? uintptr_t (step) : uintptr_t {0} - uintptr_t (step); }
+
+			// Clamps to end instead of overflowing past it.
+			void next () noexcept { current = distance () > stride () ? current + step : end; }
+			bool empty () const noexcept { return step > 0 ? current >= end : current <= end; }
+			intptr_t read () const noexcept { return current; }
+			intptr_t move () const noexcept { return current; }
+
+			bool has_size () const noexcept { return true; }
+			/**
+			 Throws, if the number of remaining items doesn't fit into intptr_t.
+			 */
+			intptr_t size () const {
+				if (empty ()) return 0;
+				auto size = (distance () - 1) / stride () + 1;
+				if (size > uintptr_t (INTPTR_MAX)) throw operation_not_supported ();
+				return static_cast<intptr_t> (size);
+			}
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector of the integers from start (inclusive) to end (exclusive), increasing by step. step may
+	 be negative, but not zero.
+	 */
+	inline range_sequence range (intptr_t start, intptr_t end, intptr_t step = 1) {
+		if (step == 0) throw operation_not_supported ();
+		return {{}, start, end, step};
+	}
+
+	/**
+	 Same as range (0, end)
+	 */
+	inline range_sequence range (intptr_t end) { return range (0, end); }
+
+	template<typename Source>
+	struct lazy_sequence : implements<Type_Class::Sequence> {
+
+		using Source_Enumerator = decltype (pure::enumerate (std::declval<Source> ()));
+		using element_type = std::decay_t<typename Source_Enumerator::value_type>;
+		using chunk_type = std::vector<element_type>;
+
+		static constexpr intptr_t chunk_size = 32;
+
+		// Shared between all copies of a lazy_sequence and all of their enumerators. Realized chunks are immutable, so
+		// an enumerator only needs the lock when it advances to a chunk it hasn't seen yet.
+		struct cache {
+			Source source;
+			std::mutex mutex;
+			std::optional<Source_Enumerator> source_enumerator;
+			std::vector<std::shared_ptr<const chunk_type>> chunks;
+			std::atomic<bool> complete {false};
+			// Number of realized items. Atomic, because size () reads it without the lock.
+			std::atomic<intptr_t> total {0};
+
+			template<typename S>
+			cache (S&& source) : source (std::forward<S> (source)) {}
+
+			std::shared_ptr<const chunk_type> realize (intptr_t chunk_index) {
+				std::lock_guard<std::mutex> lock {mutex};
+				while (intptr_t (chunks.size ()) <= chunk_index && !complete) {
+					if (!source_enumerator) source_enumerator.emplace (pure::enumerate (source));
+					auto& e = *source_enumerator;
+
+					auto chunk = std::make_shared<chunk_type> ();
+					chunk->reserve (chunk_size);
+					for (; !e.empty () && intptr_t (chunk->size ()) < chunk_size; e.next ())
+						chunk->emplace_back (e.move ());
+
+					total.fetch_add (intptr_t (chunk->size ()), std::memory_order_relaxed);
+					if (e.empty ()) {
+						source_enumerator.reset ();
+						complete = true;
+					}
+					if (!chunk->empty ()) chunks.emplace_back (std::move (chunk));
+				}
+				return chunk_index < intptr_t (chunks.size ()) ? chunks[chunk_index] : nullptr;
+			}
+		};
+
+		std::shared_ptr<cache> shared_cache;
+
+		lazy_sequence (std::shared_ptr<cache> shared_cache) : shared_cache {std::move (shared_cache)} {}
+
+		struct enumerator {
+			std::shared_ptr<cache> shared_cache;
+			std::shared_ptr<const chunk_type> chunk;
+			intptr_t chunk_index = 0;
+			intptr_t offset = 0;
+
+			using value_type = element_type;
+
+			enumerator (const lazy_sequence& owner) :
+					shared_cache {owner.shared_cache},
+					chunk {shared_cache->realize (0)} {}
+
+			void next () {
+				if (++offset == intptr_t (chunk->size ())) {
+					chunk = shared_cache->realize (++chunk_index);
+					offset = 0;
+				}
+			}
+			bool empty () const { return !chunk; }
+			const element_type& read () const { return (*chunk)[offset]; }
+			element_type move () const { return (*chunk)[offset]; }
+
+			bool has_size () const { return shared_cache->complete; }
+			intptr_t size () const { return shared_cache->total.load () - (chunk_index * chunk_size + offset); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector, which caches the items of vec the first time they are enumerated. Items are realized in
+	 chunks of 32, so the cost of enumerating vec (e.g. a map or filter) is paid only once, no matter how often the
+	 result is enumerated. Copies share the cache, which may be enumerated concurrently from multiple threads.
+	 @param vec The source vector
+	 */
+	template<typename V>
+	auto lazy_seq (V&& vec) {
+		using cache = typename lazy_sequence<V>::cache;
+		return lazy_sequence<V> {std::make_shared<cache> (std::forward<V> (vec))};
+	};
+
 	/**
 	 Functional style looping. f has to be a function taking two arguments: An accumulated result and a next value
 	 to apply to the result. reduce returns the result of applying f to all the values in vec, starting with an
@@ -181,4 +730,335 @@ namespace pure {
 
 		return std::move (result);
 	};
+
+	namespace detail {
+		/**
+		 Returns the utf8 bytes of the string s. Views are read in place instead of creating a terminated copy.
+		 */
+		template<typename T>
+		std::pair<const char*, intptr_t> string_bytes (const T& s) {
+			if constexpr (std::is_base_of_v<var, T>) {
+				switch (s.tag ()) {
+					case Var_Tag_Pointer : {
+						auto view = dynamic_cast<const Basic::String_View*> (s.operator-> ());
+						if (view) return {view->data, view->num_bytes};
+					}
+					default : break;
+				}
+			}
+			return {pure::raw_cstring (s), pure::raw_cstring_length (s)};
+		}
+
+		/**
+		 Returns a view of the whole string s. Held strings and views are shared, identifiers are referenced in place
+		 and all other strings are copied once.
+		 */
+		template<typename T>
+		immediate<Basic::String_View> string_view_of (const T& s) {
+			if constexpr (std::is_same_v<type_class<T>, Type_Class::Identifier>) {
+				return {s.string, s.length};
+			}
+			else {
+				if constexpr (std::is_base_of_v<var, T>) {
+					switch (s.tag ()) {
+						case Var_Tag_Pointer : {
+							auto view = dynamic_cast<const Basic::String_View*> (s.operator-> ());
+							if (view) return {*view};
+						}
+						default : break;
+					}
+				}
+				if (!String (s)) throw operation_not_supported ();
+				return {Basic::String_View::owner_t {s}};
+			}
+		}
+
+		/**
+		 Returns a pointer to the first occurrence of needle in haystack or nullptr. Candidates are located with
+		 memchr, which the standard library implements with SIMD instructions.
+		 */
+		static inline const char* find_bytes (const char* haystack, intptr_t haystack_length,
+											  const char* needle, intptr_t needle_length) {
+			if (needle_length == 0) return haystack;
+			if (needle_length > haystack_length) return nullptr;
+			const char* end = haystack + haystack_length - needle_length + 1;
+			for (const char* pos = haystack; pos < end; ++pos) {
+				pos = static_cast<const char*> (std::memchr (pos, needle[0], end - pos));
+				if (!pos) return nullptr;
+				if (std::memcmp (pos + 1, needle + 1, needle_length - 1) == 0) return pos;
+			}
+			return nullptr;
+		}
+	}
+
+	/**
+	 Returns a view of the code points [start, end) of the string s, which shares the storage of s.
+	 */
+	template<typename S>
+	immediate<Basic::String_View> subs (const S& s, intptr_t start, intptr_t end) {
+		return detail::string_view_of (s)->slice (start, end);
+	}
+
+	/**
+	 Returns a view of the code points of s starting at start.
+	 */
+	template<typename S>
+	immediate<Basic::String_View> subs (const S& s, intptr_t start) {
+		auto view = detail::string_view_of (s);
+		auto pos = view->code_point_position (start);
+		if (!pos) throw operation_not_supported ();
+		return view->slice_bytes (pos, view->data + view->num_bytes - pos);
+	}
+
+	struct split_sequence : implements<Type_Class::Sequence> {
+		immediate<Basic::String_View> source;
+		immediate<Basic::String_View> separator;
+
+		struct enumerator {
+			using value_type = immediate<Basic::String_View>;
+
+			const split_sequence& owner;
+			const char* piece;
+			const char* piece_end;
+			bool done;
+
+			enumerator (const split_sequence& owner) : owner {owner}, piece {owner.source->data}, done {false} {
+				find_piece_end ();
+			}
+
+			void find_piece_end () {
+				const char* end = owner.source->data + owner.source->num_bytes;
+				piece_end = detail::find_bytes (piece, end - piece, owner.separator->data, owner.separator->num_bytes);
+				if (!piece_end) piece_end = end;
+			}
+
+			void next () {
+				if (piece_end == owner.source->data + owner.source->num_bytes) done = true;
+				else {
+					piece = piece_end + owner.separator->num_bytes;
+					find_piece_end ();
+				}
+			}
+			bool empty () const { return done; }
+			value_type read () const { return owner.source->slice_bytes (piece, piece_end - piece); }
+			value_type move () const { return read (); }
+
+			bool has_size () const { return false; }
+			intptr_t size () const { throw operation_not_supported (); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+
+	/**
+	 Returns a (lazy) vector of views of the parts of s between occurrences of sep. Adjacent separators produce empty
+	 parts, so the result always contains one more item than the number of occurrences of sep.
+	 @param s The string to split
+	 @param sep A non-empty separator string
+	 */
+	template<typename S, typename Sep>
+	split_sequence split (const S& s, const Sep& sep) {
+		auto separator = detail::string_view_of (sep);
+		if (separator->num_bytes == 0) throw operation_not_supported ();
+		return {{}, detail::string_view_of (s), std::move (separator)};
+	}
+
+	/**
+	 Returns a string consisting of the strings in seq separated by sep. seq is enumerated once and its items are
+	 kept until the length of the result is known, so the result is copied into a single allocation.
+	 @param sep The separator string
+	 @param seq A vector of strings
+	 */
+	template<typename Sep, typename V>
+	var join (const Sep& sep, const V& seq) {
+		auto [sep_data, sep_length] = detail::string_bytes (sep);
+
+		using item_type = std::decay_t<typename decltype (pure::enumerate (seq))::value_type>;
+		std::vector<item_type> items;
+		auto enumerator = pure::enumerate (seq);
+		if (enumerator.has_size ()) items.reserve (enumerator.size ());
+		for (; !enumerator.empty (); enumerator.next ()) items.emplace_back (enumerator.move ());
+
+		intptr_t total_length = items.size () > 1 ? intptr_t (items.size () - 1) * sep_length : 0;
+		for (const auto& item : items) total_length += detail::string_bytes (item).second;
+
+		auto result = Basic::String::create_empty (Basic::String::capacity_needed_for_length (total_length));
+		bool first = true;
+		for (const auto& item : items) {
+			if (!first) result->append_cstring (sep_data, sep_length);
+			first = false;
+			auto [data, length] = detail::string_bytes (item);
+			result->append_cstring (data, length);
+		}
+		return var {std::move (result)};
+	}
+
+	/**
+	 Returns the index of the first code point of the first occurrence of needle in s or -1, if s doesn't contain
+	 needle.
+	 */
+	template<typename S, typename Needle>
+	intptr_t index_of (const S& s, const Needle& needle) {
+		auto [data, length] = detail::string_bytes (s);
+		auto [needle_data, needle_length] = detail::string_bytes (needle);
+		auto pos = detail::find_bytes (data, length, needle_data, needle_length);
+		return pos ? utf8::count (data, pos - data) : -1;
+	}
+
+	/**
+	 Returns true if the string s starts with prefix.
+	 */
+	template<typename S, typename Prefix>
+	bool starts_with (const S& s, const Prefix& prefix) {
+		auto [data, length] = detail::string_bytes (s);
+		auto [prefix_data, prefix_length] = detail::string_bytes (prefix);
+		return prefix_length <= length && std::memcmp (data, prefix_data, prefix_length) == 0;
+	}
+
+	/**
+	 Returns a copy of the string s, in which every occurrence of from is replaced with to. Occurrences are counted
+	 first, so the result is copied into a single allocation.
+	 @param from A non-empty string
+	 */
+	template<typename S, typename From, typename To>
+	var replace (const S& s, const From& from, const To& to) {
+		auto [data, length] = detail::string_bytes (s);
+		auto [from_data, from_length] = detail::string_bytes (from);
+		auto [to_data, to_length] = detail::string_bytes (to);
+		if (from_length == 0) throw operation_not_supported ();
+
+		const char* end = data + length;
+		intptr_t num_occurrences = 0;
+		for (auto pos = data; (pos = detail::find_bytes (pos, end - pos, from_data, from_length)); pos += from_length)
+			++num_occurrences;
+
+		auto result = Basic::String::create_empty (
+				Basic::String::capacity_needed_for_length (length + num_occurrences * (to_length - from_length)));
+		auto pos = data;
+		for (intptr_t i = 0; i < num_occurrences; ++i) {
+			auto match = detail::find_bytes (pos, end - pos, from_data, from_length);
+			result->append_cstring (pos, match - pos);
+			result->append_cstring (to_data, to_length);
+			pos = match + from_length;
+		}
+		result->append_cstring (pos, end - pos);
+		return var {std::move (result)};
+	}
+
+	namespace detail {
+		template<typename S>
+		string_builder::string_type map_case (const S& s, unicode::case_mapping mapping) {
+			auto [data, length] = string_bytes (s);
+			const char* end = data + length;
+			string_builder result {length};
+			for (const char* pos = data; pos < end;) {
+				result.reserve (end - pos);
+				auto num_ascii = unicode::map_ascii_prefix (pos, result.result->str_end, end - pos, mapping);
+				result.result->append_written (num_ascii);
+				pos += num_ascii;
+				if (pos == end) break;
+
+				char32_t mapped[3];
+				auto num_mapped = unicode::map_case (utf8::read_char_and_advance (pos), mapping, mapped);
+				result.reserve (3 * 4);
+				for (intptr_t i = 0; i < num_mapped; ++i) result.result->append_char (mapped[i]);
+			}
+			return result.finish ();
+		}
+
+		// Enumerates the case folded code points of a utf8 string without materializing the folded string.
+		struct casefold_enumerator {
+			const char* position;
+			const char* end;
+			char32_t pending[3];
+			intptr_t num_pending = 0;
+			intptr_t next_pending = 0;
+
+			// Returns the next folded code point or 0 at the end of the string.
+			char32_t next () {
+				if (next_pending < num_pending) return pending[next_pending++];
+				if (position == end) return 0;
+				if (static_cast<signed char> (*position) >= 0) {
+					return static_cast<char32_t> (unicode::detail::map_ascii (*position++, unicode::case_mapping::fold));
+				}
+				num_pending = unicode::map_case (utf8::read_char_and_advance (position), unicode::case_mapping::fold,
+												 pending);
+				next_pending = 1;
+				return pending[0];
+			}
+		};
+	}
+
+	/**
+	 Returns the lower case version of the string s according to the default case mapping of the Unicode standard.
+	 Ascii characters are mapped 16 bytes at a time. Results up to 127 bytes don't allocate.
+	 */
+	template<typename S>
+	auto lower (const S& s) { return detail::map_case (s, unicode::case_mapping::lower); }
+
+	/**
+	 Returns the upper case version of the string s. The result may contain more code points than s, e.g. the upper
+	 case of "stra\u00DFe" is "STRASSE".
+	 */
+	template<typename S>
+	auto upper (const S& s) { return detail::map_case (s, unicode::case_mapping::upper); }
+
+	/**
+	 Returns the case folded version of the string s. Strings, which only differ in case, have the same case folding.
+	 */
+	template<typename S>
+	auto casefold (const S& s) { return detail::map_case (s, unicode::case_mapping::fold); }
+
+	/**
+	 Returns the canonical composition (NFC) of the string s. Strings, which only consist of code points below
+	 U+0300, are already normalized and are copied as a whole.
+	 */
+	template<typename S>
+	auto nfc (const S& s) {
+		auto [data, length] = detail::string_bytes (s);
+		auto prefix_length = unicode::nfc_prefix (data, length);
+		detail::string_builder result {length};
+		result.write_raw_bytes (reinterpret_cast<const uint8_t*> (data), prefix_length);
+		if (prefix_length == length) return result.finish ();
+
+		std::vector<char32_t> code_points;
+		unicode::nfc (data + prefix_length, data + length, code_points);
+		for (auto c : code_points) {
+			result.reserve (4);
+			result.result->append_char (c);
+		}
+		return result.finish ();
+	}
+
+	/**
+	 Compares the strings lhs and rhs ignoring case, which is equivalent to comparing their case foldings. Returns -1,
+	 0 or 1. Doesn't allocate.
+	 */
+	template<typename LHS, typename RHS>
+	int casefold_compare (const LHS& lhs, const RHS& rhs) {
+		auto [lhs_data, lhs_length] = detail::string_bytes (lhs);
+		auto [rhs_data, rhs_length] = detail::string_bytes (rhs);
+		detail::casefold_enumerator l {lhs_data, lhs_data + lhs_length, {}}, r {rhs_data, rhs_data + rhs_length, {}};
+		for (;;) {
+			auto a = l.next ();
+			auto b = r.next ();
+			if (a != b) return a < b ? -1 : 1;
+			if (a == 0) return 0;
+		}
+	}
+
+	/**
+	 Returns true if the strings lhs and rhs only differ in case.
+	 */
+	template<typename LHS, typename RHS>
+	bool casefold_equal (const LHS& lhs, const RHS& rhs) { return casefold_compare (lhs, rhs) == 0; }
+
+	/**
+	 Hash code consistent with casefold_equal, i.e. strings, which only differ in case, have the same hash code.
+	 */
+	template<typename S>
+	int64_t casefold_hash (const S& s) {
+		auto folded = casefold (s);
+		return detail::hash_cstring_with_length (folded->cstring (), folded->cstring_length ());
+	}
 }
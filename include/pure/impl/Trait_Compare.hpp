@@ -4,6 +4,8 @@
 #include <pure/types/var.hpp>
 #include <pure/support/utf8.hpp>
 #include <pure/support/tuple.hpp>
+#include <cstring>
+#include <vector>
 
 namespace pure {
 	namespace detail {
@@ -82,13 +84,19 @@ namespace pure {
 			return false;
 		};
 
-		template<typename Eq, typename LHS, typename RHS>
-		bool equal_map (const Eq& eq, LHS&& lhs, intptr_t lhs_count, const RHS& rhs) {
+		/**
+		 Compares a map, which supports find and count, to any enumerable mapping. Looks up each key of rhs in lhs, so
+		 that missing keys don't throw.
+		 */
+		template<typename Eq, typename Container, typename RHS>
+		bool equal_map (const Eq& eq, const Container& lhs, const RHS& rhs) {
 			if constexpr (Trait_Enumerable<RHS>::implemented) {
-				if (pure::category_id (rhs) == Any_Function.id && pure::count (rhs) == lhs_count) {
-					for (; !lhs.empty (); lhs.next ()) {
-						auto&& element = lhs.read ();
-						if (!eq (pure::apply (rhs, pure::first (element)), pure::second (element))) return false;
+				if (pure::category_id (rhs) == Any_Function.id && pure::Enumerable (rhs) &&
+					pure::count (rhs) == lhs.count ()) {
+					for (auto enumerator = pure::enumerate (rhs); !enumerator.empty (); enumerator.next ()) {
+						auto&& element = enumerator.read ();
+						auto found = lhs.find (pure::first (element));
+						if (!found || !eq (*found, pure::second (element))) return false;
 					}
 					return true;
 				}
@@ -96,6 +104,19 @@ namespace pure {
 			return false;
 		};
 
+		/**
+		 Compares two map containers of the same type without enumerators.
+		 */
+		template<typename Eq, typename Container>
+		bool equal_map_container (const Eq& eq, const Container& lhs, const Container& rhs) {
+			if (lhs.size () != rhs.size ()) return false;
+			for (const auto& element : lhs) {
+				auto found = rhs.find (element.first);
+				if (!found || !eq (element.second, *found)) return false;
+			}
+			return true;
+		}
+
 		template<typename Cmp, typename LHS, typename RHS>
 		int compare_enumerator (const Cmp& cmp, LHS&& lhs, RHS&& rhs) {
 			while (!lhs.empty ()) {
@@ -108,6 +129,40 @@ namespace pure {
 			return rhs.empty () ? 0 : -1;
 		};
 
+		/**
+		 Compares the containers of two vectors of the same type element by element, without enumerators. Contiguous
+		 integer elements are compared with memcmp, except for the packed std::vector<bool>.
+		 */
+		template<typename Eq, typename Container>
+		bool equal_container (const Eq& eq, const Container& lhs, const Container& rhs) {
+			using element_type = typename Container::value_type;
+			if (lhs.size () != rhs.size ()) return false;
+			if constexpr (std::is_integral_v<element_type> && !std::is_same_v<element_type, bool> &&
+						  std::is_same_v<Container, std::vector<element_type>>) {
+				return lhs.empty () || std::memcmp (lhs.data (), rhs.data (), lhs.size () * sizeof (element_type)) == 0;
+			}
+			else {
+				auto r = rhs.begin ();
+				for (const auto& l : lhs) {
+					if (!eq (l, *r)) return false;
+					++r;
+				}
+				return true;
+			}
+		}
+
+		template<typename Cmp, typename Container>
+		int compare_container (const Cmp& cmp, const Container& lhs, const Container& rhs) {
+			auto r = rhs.begin ();
+			auto r_end = rhs.end ();
+			for (const auto& l : lhs) {
+				if (r == r_end) return 1;
+				if (auto c = cmp (l, *r); c) return c;
+				++r;
+			}
+			return r == r_end ? 0 : -1;
+		}
+
 		template<typename Cmp, typename LHS, typename RHS>
 		int compare_sequence (const Cmp& cmp, LHS&& lhs, const RHS& rhs) {
 			if constexpr (Trait_Enumerable<RHS>::implemented) {
@@ -258,7 +313,7 @@ namespace pure {
 			auto rhs_category = pure::category_id (rhs);
 			if constexpr (Trait_CString<RHS>::implemented) {
 				if (rhs_category == String.id)
-					return detail::signum (utf8::string_compare (lhs, pure::raw_cstring (rhs)));
+					return utf8::string_compare (lhs, pure::raw_cstring (rhs));
 			}
 			return detail::simple_compare (String.id, rhs_category);
 		}
@@ -288,7 +343,8 @@ namespace pure {
 			auto rhs_category = pure::category_id (rhs);
 			if constexpr (Trait_CString<RHS>::implemented) {
 				if (rhs_category == String.id)
-					return detail::signum (utf8::string_compare (lhs.string, pure::raw_cstring (rhs)));
+					return utf8::string_compare (lhs.string, lhs.length, pure::raw_cstring (rhs),
+												 pure::raw_cstring_length (rhs));
 			}
 			return detail::simple_compare (String.id, rhs_category);
 		}
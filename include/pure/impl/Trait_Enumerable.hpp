@@ -43,7 +43,7 @@ namespace pure {
 
 		static cstring_enumerator enumerate (const T& self) { return {self.string}; }
 
-		static intptr_t count (const T& self) { return utf8::count (self.string); }
+		static intptr_t count (const T& self) { return utf8::count (self.string, self.length); }
 		static bool Empty (const T& self) { return self.length == 0; }
 
 		static char32_t nth (const T& self, intptr_t n) { return Basic::String::cstring_nth (self.string, n); }
@@ -323,7 +323,7 @@ namespace pure {
 
 		static intptr_t count (const T& self) {
 			auto enumerator = self.enumerate ();
-			if constexpr (enumerator.has_size ()) return enumerator.size ();
+			if (enumerator.has_size ()) return enumerator.size ();
 			else {
 				intptr_t result = 0;
 				for (; !enumerator.empty (); enumerator.next ()) {
@@ -19,6 +19,25 @@ namespace pure {
 			static constexpr bool value = std::is_convertible_v<Index, intptr_t>;
 		};
 
+		template<typename Key>
+		bool cstring_lookup (const char* str, const Key& key, var* result) {
+			intptr_t index;
+			auto pos = index_key (key, index) && index >= 0 ? utf8::advance_n (str, index) : nullptr;
+			if (!pos || !*pos) return false;
+			if (result) *result = utf8::read_char (pos);
+			return true;
+		}
+
+		/**
+		 Lookup by index for sequences, whose elements are accessed with nth.
+		 */
+		template<typename T, typename Key>
+		bool sequence_lookup (const T& self, const Key& key, var* result) {
+			intptr_t index;
+			if (!index_key (key, index) || index < 0 || index >= pure::count (self)) return false;
+			if (result) *result = pure::nth (self, index);
+			return true;
+		}
 	}
 	template<typename T>
 	struct Trait_Functional<T, Type_Class::CString> : Trait_Definition {
@@ -31,6 +50,11 @@ namespace pure {
 				throw operation_not_supported ();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			return detail::cstring_lookup (self, key, result);
+		}
+
 		template<typename... Args>
 		static constexpr bool Applicable = detail::Sequence_Applicable<Args...>::value;
 
@@ -65,6 +89,11 @@ namespace pure {
 				throw operation_not_supported ();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			return detail::cstring_lookup (self.string, key, result);
+		}
+
 		template<typename... Args>
 		static constexpr bool Applicable = detail::Sequence_Applicable<Args...>::value;
 
@@ -97,6 +126,15 @@ namespace pure {
 			}
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			switch (self.tag ()) {
+				case Var::Tag::String : return detail::cstring_lookup (self.get_cstring (), key, result);
+				case Var_Tag_Pointer : return self->lookup (key, result);
+				default : throw operation_not_supported ();
+			}
+		}
+
 		static intptr_t arity (const T& self) {
 			switch (self.tag ()) {
 				case Var::Tag::String : return 1;
@@ -216,6 +254,9 @@ namespace pure {
 
 		static bool Variadic (const T&) { return false; }
 
+		template<typename Key>
+		static bool lookup (const T&, const Key&, var*) { throw operation_not_supported (); }
+
 		template<typename... Args>
 		static var set (const T&, Args&& ...) { throw operation_not_supported (); }
 	};
@@ -238,6 +279,9 @@ namespace pure {
 
 		static bool Variadic (const T&) { return is_Variadic; }
 
+		template<typename Key>
+		static bool lookup (const T&, const Key&, var*) { throw operation_not_supported (); }
+
 		template<typename... Args>
 		static var set (const T&, Args&& ...) { throw operation_not_supported (); }
 	};
@@ -255,6 +299,13 @@ namespace pure {
 				throw operation_not_supported();
 		}
 
+		// Every value is in the domain of a set.
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			if (result) *result = self (key);
+			return true;
+		}
+
 		static intptr_t arity (const T&) { return 1; }
 		static bool Variadic (const T&) { return false; }
 
@@ -275,6 +326,14 @@ namespace pure {
 				throw operation_not_supported();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			intptr_t index;
+			if (!detail::index_key (key, index) || index < 0 || index >= intptr_t (sizeof... (Elements))) return false;
+			if (result) *result = detail::tuple::generic_nth (self, index);
+			return true;
+		}
+
 		static intptr_t arity (const T& self) { return 1; }
 		static bool Variadic (const T& self) { return false; }
 
@@ -298,6 +357,11 @@ namespace pure {
 				throw operation_not_supported();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			return detail::sequence_lookup (self, key, result);
+		}
+
 		static intptr_t arity (const T& self) { return 1; }
 		static bool Variadic (const T& self) { return false; }
 
@@ -321,6 +385,11 @@ namespace pure {
 				throw operation_not_supported();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			return detail::sequence_lookup (self, key, result);
+		}
+
 		static intptr_t arity (const T& self) { return 1; }
 		static bool Variadic (const T& self) { return false; }
 
@@ -344,6 +413,14 @@ namespace pure {
 				throw operation_not_supported();
 		}
 
+		template<typename Key>
+		static bool lookup (const T& self, const Key& key, var* result) {
+			auto index = self.get_id_index (key);
+			if (index == -1) return false;
+			if (result) *result = self.nth_element (index);
+			return true;
+		}
+
 		static intptr_t arity (const T& self) { return 1; }
 		static bool Variadic (const T& self) { return false; }
 
@@ -5,60 +5,205 @@
 #include <pure/traits.hpp>
 #include <pure/support/tuple.hpp>
 #include <pure/support/record.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
 
 namespace pure {
-	namespace detail {
+	/**
+	 Incremental hash state, which hashes a stream of bytes and values in a single pass without holding them. Bytes fed
+	 through update are hashed exactly like one contiguous string, e.g. hasher {}.update (a, 3).update (b, 5).finish ()
+	 equals pure::hash of the 8 byte string a + b. update (value) feeds the 8 bytes of pure::hash (value), which is how
+	 sequences, tuples and pairs are hashed.
+	 */
+	struct hasher {
+		explicit hasher (uint64_t seed = detail::wyhash::string_seed) noexcept
+				: seed {detail::wyhash::initial_state (seed)}, see1 {0}, see2 {0} {}
+
+		hasher& update (const char* data, intptr_t num_bytes) {
+			length += num_bytes;
+			while (num_bytes > 0) {
+				if (num_pending == 0 && num_bytes > 48) {
+					do {
+						absorb (data);
+						data += 48;
+						num_bytes -= 48;
+					} while (num_bytes > 48);
+					std::memcpy (buffer, data - 16, 16);
+				}
+				auto n = std::min<intptr_t> (num_bytes, 64 - num_pending);
+				std::memcpy (buffer + 16 + num_pending, data, n);
+				num_pending += n;
+				data += n;
+				num_bytes -= n;
+				if (num_pending > 48) {
+					absorb (buffer + 16);
+					num_pending -= 48;
+					std::memmove (buffer, buffer + 48, 16 + num_pending);
+				}
+			}
+			return *this;
+		}
+
+		hasher& update (const void* data, intptr_t num_bytes) {
+			return update (static_cast<const char*> (data), num_bytes);
+		}
+
 		template<typename T>
-		int32_t hash_sequence (T&& enumerator) {
-			int32_t result = 0x1;
-			for (; !enumerator.empty (); enumerator.next ()) {
-				result = murmur3::hash_combine_ordered (result, pure::hash (enumerator.read ()));
+		hasher& update (const T& value) {
+			char bytes[8];
+			uint64_t h = static_cast<uint64_t> (pure::hash (value));
+			for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char> (h >> (8 * i));
+			return update (bytes, 8);
+		}
+
+		int64_t finish () const noexcept {
+			return detail::wyhash::finish (buffer + 16, num_pending, length, absorbed ? seed ^ see1 ^ see2 : seed);
+		}
+
+	private:
+		void absorb (const char* block) {
+			if (!absorbed) {
+				see1 = see2 = seed;
+				absorbed = true;
 			}
-			return murmur3::fmix (result);
+			detail::wyhash::absorb (block, seed, see1, see2);
+		}
+
+		uint64_t seed, see1, see2;
+		intptr_t length = 0;
+		intptr_t num_pending = 0;
+		bool absorbed = false;
+		// 16 bytes of history for the overlapping reads of finish followed by up to 64 pending bytes.
+		char buffer[16 + 64] = {};
+	};
+
+	namespace detail {
+		/**
+		 Lazily computed hash code of an immutable value object. Containers keep their hash in a hash_cache, so using
+		 them as keys of a map only enumerates their elements once and nested containers reuse the hashes of their
+		 children. Threads may compute the hash concurrently, since they all store the same result.
+		 */
+		struct hash_cache {
+			hash_cache () = default;
+			hash_cache (const hash_cache& other) noexcept {
+				if (other.valid.load (std::memory_order_acquire)) {
+					value.store (other.value.load (std::memory_order_relaxed), std::memory_order_relaxed);
+					valid.store (true, std::memory_order_release);
+				}
+			}
+
+			template<typename Fn>
+			int64_t get (Fn&& compute) const {
+				if (valid.load (std::memory_order_acquire)) return value.load (std::memory_order_relaxed);
+				auto result = compute ();
+				value.store (result, std::memory_order_relaxed);
+				valid.store (true, std::memory_order_release);
+				return result;
+			}
+
+			/**
+			 Has to be called before the value object is modified in place.
+			 */
+			void reset () noexcept { valid.store (false, std::memory_order_relaxed); }
+
+		private:
+			mutable std::atomic<int64_t> value {0};
+			mutable std::atomic<bool> valid {false};
+		};
+
+		template<typename T>
+		int64_t hash_sequence (T&& enumerator) {
+			hasher result {wyhash::sequence_seed};
+			for (; !enumerator.empty (); enumerator.next ()) result.update (enumerator.read ());
+			return result.finish ();
 		}
 
 		namespace tuple {
 			template<intptr_t index, intptr_t count, typename T>
-			int32_t hash (const T& self, int32_t result = 0x1) {
-				if constexpr (index == count) return murmur3::fmix (result);
-				else return hash<index + 1, count> (self, murmur3::hash_combine_ordered (result, pure::hash (
-							tuple::nth<index> (self))));
+			int64_t hash (const T& self, hasher result = hasher {wyhash::sequence_seed}) {
+				if constexpr (index == count) return result.finish ();
+				else return hash<index + 1, count> (self, result.update (tuple::nth<index> (self)));
 			}
 		}
 
 		template<typename First, typename Second>
-		int32_t hash_pair (const First& first, const Second& second) {
-			int32_t result = 0x1;
-			result = murmur3::hash_combine_ordered (result, pure::hash (first));
-			result = murmur3::hash_combine_ordered (result, pure::hash (second));
-			return murmur3::fmix (result);
+		int64_t hash_pair (const First& first, const Second& second) {
+			return hasher {wyhash::sequence_seed}.update (first).update (second).finish ();
 		};
 
 		template<intptr_t index = 0, typename T>
-		int32_t hash_record (const T& self, int32_t result = 0x3) {
-			if constexpr (index == T::count) return murmur3::fmix (result);
-			else return hash_record<index + 1> (self, murmur3::hash_combine_unordered (result, hash_pair (
+		int64_t hash_record (const T& self, int64_t result = 0x3) {
+			if constexpr (index == T::count) return wyhash::fmix (result);
+			else return hash_record<index + 1> (self, wyhash::hash_combine_unordered (result, hash_pair (
 						self.template nth_id<index> (), self.template nth_element<index> ())));
 		};
 
 		template<typename T>
-		int32_t hash_enumerable_unordered (const T& self) {
-			int32_t result = 0x3;
+		int64_t hash_enumerable_unordered (const T& self) {
+			int64_t result = 0x3;
 			for (auto enumerator = pure::enumerate (self); !enumerator.empty (); enumerator.next ()) {
-				result = murmur3::hash_combine_unordered (result, pure::hash (enumerator.read ()));
+				result = wyhash::hash_combine_unordered (result, pure::hash (enumerator.read ()));
 			}
-			return murmur3::fmix (result);
+			return wyhash::fmix (result);
 		}
 
 		template<typename T>
-		int32_t hash_map (T&& enumerator) {
-			int32_t result = 0x3;
+		int64_t hash_map (T&& enumerator) {
+			int64_t result = 0x3;
 			for (; !enumerator.empty (); enumerator.next ()) {
 				auto&& element = enumerator.read ();
-				result = murmur3::hash_combine_unordered (result,
-														  hash_pair (pure::first (element), pure::second (element)));
+				result = wyhash::hash_combine_unordered (result,
+														 hash_pair (pure::first (element), pure::second (element)));
+			}
+			return wyhash::fmix (result);
+		}
+
+		// Whether the elements of T may be key value pairs, which is decided by its category at runtime.
+		template<typename T, typename = void>
+		struct has_pair_elements : std::false_type {};
+
+		template<typename T>
+		struct has_pair_elements<T, decltype (pure::first (pure::enumerate (std::declval<const T&> ()).read ()),
+											  pure::second (pure::enumerate (std::declval<const T&> ()).read ()),
+											  void ())> : std::true_type {};
+
+		/**
+		 Hash of self keyed with k, which like pure::hash is consistent with pure::equal. Strings are hashed with SipHash
+		 directly. Vectors, tuples, maps and records combine the keyed hashes of their elements, so collisions of
+		 the unkeyed hash of strings don't carry over. All other values, like numbers, rehash their unkeyed hash with k.
+		 */
+		template<typename T>
+		int64_t keyed_hash (const T& self, const siphash::key& k) {
+			auto category = pure::category_id (self);
+			if constexpr (Trait_CString<T>::implemented) {
+				if (category == String.id) {
+					return siphash::hash_raw_bytes (pure::raw_cstring (self), pure::raw_cstring_length (self), k);
+				}
+			}
+			if constexpr (Trait_Enumerable<T>::implemented) {
+				if (category == Any_Vector.id && pure::Enumerable (self)) {
+					int64_t result = 0x1;
+					for (auto enumerator = pure::enumerate (self); !enumerator.empty (); enumerator.next ()) {
+						result = wyhash::hash_combine_ordered (result, keyed_hash (enumerator.read (), k));
+					}
+					return wyhash::fmix (result);
+				}
+				if constexpr (has_pair_elements<T>::value) {
+					if (category == Any_Function.id && pure::Enumerable (self)) {
+						int64_t result = 0x3;
+						for (auto enumerator = pure::enumerate (self); !enumerator.empty (); enumerator.next ()) {
+							auto&& element = enumerator.read ();
+							auto entry = wyhash::hash_combine_ordered (keyed_hash (pure::first (element), k),
+																	   keyed_hash (pure::second (element), k));
+							result = wyhash::hash_combine_unordered (result, wyhash::fmix (entry));
+						}
+						return wyhash::fmix (result);
+					}
+				}
 			}
-			return murmur3::fmix (result);
+			return siphash::hash_int64 (pure::hash (self), k);
 		}
 	}
 }
@@ -66,61 +211,64 @@ namespace pure {
 namespace pure {
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Nil> : Trait_Definition {
-		static int32_t hash (const T& self) { return 0; }
+		static int64_t hash (const T& self) { return 0; }
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Bool> : Trait_Definition {
-		static int32_t hash (const T& self) { return self ? 1231 : 1237; }
+		static int64_t hash (const T& self) { return self ? 1231 : 1237; }
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Int> : Trait_Definition {
-		static int32_t hash (const T& self) {
-			if constexpr (sizeof (T) < sizeof (int32_t) || (sizeof (T) == sizeof (int32_t) && std::is_signed_v<T>))
-				return detail::murmur3::hash_int32 (self, 0);
-			else
-				return detail::murmur3::hash_int64 (self, 0);
+		static int64_t hash (const T& self) {
+			return detail::wyhash::hash_int64 (static_cast<int64_t> (self), 0);
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Double> : Trait_Definition {
-		static int32_t hash (const T& self) {
-			if ((double)(int64_t)self == self) return detail::murmur3::hash_int64 ((int64_t)self, 0);
-			else return 0;
+		static int64_t hash (const T& self) {
+			// Integral values hash like integers. All other values hash their bit pattern, with all NaNs mapped to one.
+			if (self > -9.2e18 && self < 9.2e18 && static_cast<double> (static_cast<int64_t> (self)) == self)
+				return detail::wyhash::hash_int64 (static_cast<int64_t> (self), 0);
+			double value = self == self ? static_cast<double> (self) : std::numeric_limits<double>::quiet_NaN ();
+			uint64_t bits = 0;
+			std::memcpy (&bits, &value, sizeof (bits));
+			return detail::wyhash::hash_int64 (static_cast<int64_t> (bits), 0x9E3779B97F4A7C15);
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Character> : Trait_Definition {
-		static int32_t hash (const T& self) {
-			return detail::murmur3::hash_int32 (self, 0x3A6F10C7);
+		static int64_t hash (const T& self) {
+			return detail::wyhash::hash_int64 (static_cast<int64_t> (self), detail::wyhash::char_seed);
 		}
 	};
 
 	namespace detail {
-		int32_t hash_cstring_with_length (const char* cstr, intptr_t length) {
-			return detail::murmur3::hash_raw_bytes (cstr, length, 0xCE7E9683);
+		inline int64_t hash_cstring_with_length (const char* cstr, intptr_t length) {
+			return detail::wyhash::hash_raw_bytes (cstr, length, detail::wyhash::string_seed);
 		}
 	}
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::CString> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			return detail::hash_cstring_with_length (self, std::strlen (self));
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Identifier> : Trait_Definition {
-		static int32_t hash (const T& self) {
-			return detail::hash_cstring_with_length (self.string, self.length);
+		static int64_t hash (const T& self) {
+			if constexpr (is_static_id<T>::value) return T::hash;
+			else return detail::hash_cstring_with_length (self.string, self.length);
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Var> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			switch (self.tag ()) {
 				case Var::Tag::Nil : return pure::hash (nullptr);
 				case Var::Tag::False : return pure::hash (false);
@@ -138,28 +286,28 @@ namespace pure {
 
 	template<typename T, typename... Elements>
 	struct Trait_Hash<T, Type_Class::Tuple<Elements...>> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			return detail::tuple::hash<0, sizeof... (Elements)> (self);
 		}
 	};
 
 	template<typename T, typename Capabilities>
 	struct Trait_Hash<T, Type_Class::Iterable<Capabilities>> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			return detail::hash_sequence (pure::enumerate (self));
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Sequence> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			return detail::hash_sequence (pure::enumerate (self));
 		}
 	};
 
 	template<typename T>
 	struct Trait_Hash<T, Type_Class::Record> : Trait_Definition {
-		static int32_t hash (const T& self) {
+		static int64_t hash (const T& self) {
 			return detail::hash_record (self);
 		}
 	};
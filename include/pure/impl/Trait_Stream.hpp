@@ -6,7 +6,7 @@ namespace pure {
 	template<typename T>
 	struct Trait_Stream<T, Type_Class::File_Stream> : Trait_Definition {
 		static bool write_raw_bytes (T& self, const uint8_t* data, intptr_t num_bytes) {
-			return fwrite (data, 1, num_bytes, self) != EOF;
+			return fwrite (data, 1, num_bytes, self) == static_cast<size_t> (num_bytes);
 		}
 
 		static bool write_raw_string (T& self, const char* data) {
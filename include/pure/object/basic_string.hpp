@@ -11,6 +11,9 @@
 #include <pure/impl/Trait_From_Var.hpp>
 #include <pure/support/enumerator.hpp>
 #include <pure/impl/Trait_Print.hpp>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 namespace pure {
 	struct with_capacity_t {};
@@ -46,8 +49,14 @@ namespace pure {
 
 			using domain_t = String_t;
 
+			// Byte offset of every index_stride-th code point. Built lazily for non-ascii strings by nth, apply and set.
+			using code_point_index_t = std::vector<intptr_t>;
+			static constexpr intptr_t index_stride = 64;
+
 			intptr_t num_allocated_bytes;
 			char* str_end;
+			mutable std::atomic<code_point_index_t*> code_point_index {nullptr};
+			bool ascii = true;
 			char str[1];
 
 			static constexpr bool has_dynamic_size = true;
@@ -81,18 +90,93 @@ namespace pure {
 				str[0] = '\0';
 			}
 
+			~String () override { delete code_point_index.load (std::memory_order_relaxed); }
+
 			intptr_t remaining_capacity () const noexcept { return capacity () - cstring_length (); }
 
+			/**
+			 Returns the capacity for a copy of this string, which has to hold at least min_length bytes. The capacity
+			 at least doubles, so a sequence of transient appends copies each byte only a constant number of times
+			 on average.
+			 */
+			intptr_t grown_capacity (intptr_t min_length) const noexcept {
+				return capacity_needed_for_length (std::max (min_length, 2 * capacity () + 1));
+			}
+
 			void append_cstring (const char* str, intptr_t num_bytes) {
 				assert (remaining_capacity () >= num_bytes);
 				std::memcpy (str_end, str, num_bytes);
 				str_end += num_bytes;
 				*str_end = '\0';
+				ascii = ascii && utf8::is_ascii (str, num_bytes);
+				reset_code_point_index ();
+			}
+			/**
+			 Adds num_bytes, which have already been written to str_end, to the string.
+			 */
+			void append_written (intptr_t num_bytes) {
+				assert (remaining_capacity () >= num_bytes);
+				ascii = ascii && utf8::is_ascii (str_end, num_bytes);
+				str_end += num_bytes;
+				*str_end = '\0';
+				reset_code_point_index ();
 			}
 			void append_char (char32_t c) {
 				assert (remaining_capacity () >= utf8::bytes_required_for (c));
 				str_end = utf8::write_char (str_end, c);
 				*str_end = '\0';
+				ascii = ascii && c < 0x80;
+				reset_code_point_index ();
+			}
+
+			void reset_code_point_index () {
+				if (code_point_index.load (std::memory_order_relaxed))
+					delete code_point_index.exchange (nullptr, std::memory_order_relaxed);
+			}
+
+			const code_point_index_t& get_code_point_index () const {
+				if (auto index = code_point_index.load (std::memory_order_acquire)) return *index;
+
+				auto index = new code_point_index_t {};
+				index->reserve (cstring_length () / index_stride + 1);
+				intptr_t n = 0;
+				for (const char* pos = str; *pos; pos = utf8::advance (pos), ++n) {
+					if (n % index_stride == 0) index->push_back (pos - str);
+				}
+
+				code_point_index_t* expected = nullptr;
+				if (code_point_index.compare_exchange_strong (expected, index, std::memory_order_acq_rel))
+					return *index;
+				delete index;
+				return *expected;
+			}
+
+			/**
+			 Returns a pointer to the n-th code point, str_end if n is equal to the number of code points or nullptr
+			 if n is out of bounds. Constant time for ascii strings, otherwise at most index_stride steps from the
+			 closest entry in the code point index.
+			 */
+			char* code_point_position (intptr_t n) const {
+				auto self = const_cast<char*> (str);
+				if (n < 0) return nullptr;
+				if (ascii) return n <= cstring_length () ? self + n : nullptr;
+				if (cstring_length () > index_stride) {
+					auto& index = get_code_point_index ();
+					auto block = std::min (n / index_stride, intptr_t (index.size ()) - 1);
+					n -= block * index_stride;
+					self += index[block];
+				}
+				for (; n > 0; --n) {
+					if (*self == '\0') return nullptr;
+					self = utf8::advance (self);
+				}
+				return self;
+			}
+
+			char32_t code_point_at (intptr_t n) const {
+				auto pos = code_point_position (n);
+				if (pos && *pos) return utf8::read_char (pos);
+				else throw operation_not_supported ();
 			}
 
 			template<typename T>
@@ -105,9 +189,11 @@ namespace pure {
 				if (cstr_len == -1)
 					cstr_len = std::strlen (cstr);
 				assert (cstr_len <= capacity);
+				assert (utf8::valid (cstr, cstr_len));
 				std::memcpy (str, cstr, cstr_len);
 				str_end = str + cstr_len;
 				*str_end = '\0';
+				ascii = utf8::is_ascii (str, cstr_len);
 			}
 
 			template<typename T>
@@ -141,45 +227,53 @@ namespace pure {
 
 			bool equal (const weak<>& other) const override {
 				if (pure::category_id (other) == pure::String.id) {
-					return pure::equal (str, other->cstring ());
+					return other->cstring_length () == cstring_length () &&
+						   std::memcmp (str, other->cstring (), cstring_length ()) == 0;
 				}
 				return false;
 			}
 
 			bool equivalent (const weak<>& other) const override {
-				if (pure::category_id (other) == pure::String.id) {
-					return pure::equal (str, other->cstring ());
-				}
-				return false;
+				return equal (other);
 			}
 
 			int compare (const weak<>& other) const override {
-				return pure::compare (str, other);
+				if (pure::category_id (other) != pure::String.id) return pure::compare (str, other);
+				return utf8::string_compare (str, cstring_length (), other->cstring (), other->cstring_length ());
 			}
 
 			int equivalent_compare (const weak<>& other) const override {
-				return pure::equivalent_compare (str, other);
+				return compare (other);
 			}
 
-			int32_t hash () const override {
+			int64_t hash () const override {
 				return detail::hash_cstring_with_length (cstring (), cstring_length ());
 			}
 
 			char32_t apply (intptr_t index) const {
-				return cstring_nth (cstring (), index);
+				return code_point_at (index);
 			};
 
 			var virtual_apply (const var& a0) const override { return apply (a0); }
 
+			bool lookup (const var& key, var* result) const override {
+				intptr_t n;
+				auto pos = detail::index_key (key, n) ? code_point_position (n) : nullptr;
+				if (!pos || !*pos) return false;
+				if (result) *result = utf8::read_char (pos);
+				return true;
+			}
+
 			intptr_t arity () const noexcept override { return 1; }
 			bool Variadic () const noexcept override { return false; }
 
+			/**
+			 Replaces the code point at index with c. Appends c, if index is equal to count (), and throws
+			 operation_not_supported for any other index out of bounds.
+			 */
 			unique<String> set_persistent (const var&, intptr_t index, char32_t c) const {
-				const char* pos = str;
-				for (intptr_t i = 0; i < index; ++i) {
-					if (*pos == '\0') throw operation_not_supported (); // TODO out of bounds
-					pos = utf8::advance (pos);
-				}
+				const char* pos = code_point_position (index);
+				if (!pos) throw operation_not_supported ();
 
 				const char* tail_begin = *pos == '\0' ? pos : utf8::advance (pos);
 
@@ -193,12 +287,12 @@ namespace pure {
 				return set_persistent ({}, key, value);
 			}
 
+			/**
+			 Like set_persistent, but modifies this string in place, if it has enough capacity.
+			 */
 			unique<String, maybe_nil> set_transient (var&&, intptr_t index, char32_t c) {
-				char* pos = str;
-				for (intptr_t i = 0; i < index; ++i) {
-					if (*pos == '\0') throw operation_not_supported (); // TODO out of bounds
-					pos = utf8::advance (pos);
-				}
+				char* pos = code_point_position (index);
+				if (!pos) throw operation_not_supported ();
 
 				char* tail_begin = *pos == '\0' ? pos : utf8::advance (pos);
 
@@ -206,7 +300,7 @@ namespace pure {
 				intptr_t num_bytes_new_char = utf8::bytes_required_for (c);
 
 				if (num_bytes_new_char - num_bytes_current_char > remaining_capacity ()) {
-					auto result = create_from_cstring (capacity_needed_for_length (cstring_length () * 2 + 4),
+					auto result = create_from_cstring (grown_capacity (cstring_length () + num_bytes_new_char),
 													   this->str, pos - this->str);
 					result->append_char (c);
 					result->append_cstring (tail_begin, this->str_end - tail_begin);
@@ -222,6 +316,8 @@ namespace pure {
 				}
 				this->str_end = new_str_end;
 				utf8::write_char (pos, c);
+				ascii = ascii && c < 0x80;
+				reset_code_point_index ();
 				return nullptr;
 			};
 
@@ -234,16 +330,16 @@ namespace pure {
 			cstring_enumerator enumerate () const noexcept { return {cstring ()}; }
 			generic_enumerator virtual_enumerate () const override { return enumerate (); }
 
-			intptr_t count () const override { return utf8::count (cstring ()); }
+			intptr_t count () const override { return utf8::count (str, cstring_length ()); }
 			bool Empty () const override { return *cstring () == '\0'; }
 
-			char32_t first () const { return cstring_nth (cstring (), 0); }
+			char32_t first () const { return code_point_at (0); }
 			var virtual_first () const override { return first (); }
 
-			char32_t second () const { return cstring_nth (cstring (), 1); }
+			char32_t second () const { return code_point_at (1); }
 			var virtual_second () const override { return second (); }
 
-			char32_t nth (intptr_t n) const { return cstring_nth (cstring (), n); }
+			char32_t nth (intptr_t n) const { return code_point_at (n); }
 			var virtual_nth (intptr_t n) const override { return nth (n); }
 
 			unique<String> append_persistent (const var&, char32_t c) const {
@@ -257,11 +353,15 @@ namespace pure {
 			};
 
 			unique<String, maybe_nil> append_transient (var&&, char32_t c) {
-				if (remaining_capacity () >= utf8::bytes_required_for (c)) {
+				auto num_bytes = utf8::bytes_required_for (c);
+				if (remaining_capacity () >= num_bytes) {
 					this->append_char (c);
 					return nullptr;
 				}
-				else return append_persistent ({}, c);
+				auto result = create_from_cstring (grown_capacity (cstring_length () + num_bytes), str,
+												   cstring_length ());
+				result->append_char (c);
+				return std::move (result);
 			}
 
 			maybe<> virtual_append_transient (var&& self, var&& element) override {
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/object/interface.hpp>
+#include <pure/object/basic_string.hpp>
+#include <pure/types/shared.hpp>
+#include <pure/support/enumerator.hpp>
+#include <pure/support/utf8.hpp>
+#include <pure/impl/Trait_Compare.hpp>
+#include <pure/impl/Trait_Hash.hpp>
+#include <pure/impl/Trait_Print.hpp>
+#include <atomic>
+#include <cstring>
+
+namespace pure {
+	namespace Basic {
+		/**
+		 String value referring to num_bytes bytes of utf8 text, which aren't owned by the view itself. An owner can
+		 be passed, which is kept alive through its reference count, so substrings of large inputs can be held in var
+		 without copying. The text doesn't need to be null-terminated. cstring () creates and caches a terminated copy
+		 in that case.
+		 */
+		struct String_View : Interface::Value {
+			using domain_t = String_t;
+			using owner_t = shared<Interface::Value, maybe_nil>;
+
+			owner_t owner;
+			const char* data;
+			intptr_t num_bytes;
+			bool null_terminated;
+			mutable std::atomic<String*> terminated_copy {nullptr};
+
+			/**
+			 View of the given bytes. The caller has to make sure, that they outlive the view.
+			 */
+			String_View (const char* data, intptr_t num_bytes) :
+					owner {nullptr}, data {data}, num_bytes {num_bytes}, null_terminated {false} {}
+
+			/**
+			 View of the whole string owner.
+			 */
+			String_View (owner_t owner) :
+					owner {std::move (owner)},
+					data {this->owner->cstring ()},
+					num_bytes {this->owner->cstring_length ()},
+					null_terminated {true} {}
+
+			/**
+			 View of num_bytes bytes starting at data, which has to point into the string owner.
+			 */
+			String_View (owner_t owner, const char* data, intptr_t num_bytes) :
+					owner {std::move (owner)}, data {data}, num_bytes {num_bytes},
+					null_terminated {data + num_bytes == this->owner->cstring () + this->owner->cstring_length ()} {
+				assert (data >= this->owner->cstring () && data + num_bytes <= this->owner->cstring () +
+																			 this->owner->cstring_length ());
+			}
+
+			/**
+			 View of num_bytes bytes starting at data, which are kept alive by owner, but don't belong to a string,
+			 e.g. because owner is a memory mapped file.
+			 */
+			String_View (owner_t owner, const char* data, intptr_t num_bytes, bool null_terminated) :
+					owner {std::move (owner)}, data {data}, num_bytes {num_bytes}, null_terminated {null_terminated} {}
+
+			String_View (String_View& other) : String_View (static_cast<const String_View&> (other)) {}
+			String_View (const String_View& other) :
+					owner {other.owner}, data {other.data}, num_bytes {other.num_bytes},
+					null_terminated {other.null_terminated} {}
+
+			~String_View () override { delete terminated_copy.load (std::memory_order_relaxed); }
+
+			int category_id () const noexcept override { return pure::String.id; }
+
+			Interface::Value* clone () const& override { return new String_View {*this}; }
+			intptr_t clone_bytes_needed () const override { return sizeof (String_View); }
+			Interface::Value* clone_placement (void* memory, intptr_t num_bytes) const& override {
+				return new (memory) String_View {*this};
+			}
+
+			const char* cstring () const override {
+				if (null_terminated) return data;
+				if (auto copy = terminated_copy.load (std::memory_order_acquire)) return copy->str;
+
+				auto copy = String::create_from_cstring (String::capacity_needed_for_length (num_bytes), data,
+														 num_bytes).release ();
+				String* expected = nullptr;
+				if (terminated_copy.compare_exchange_strong (expected, copy, std::memory_order_acq_rel))
+					return copy->str;
+				delete copy;
+				return expected->str;
+			}
+
+			intptr_t cstring_length () const override { return num_bytes; }
+
+			bool equal (const weak<>& other) const override {
+				if (pure::category_id (other) == pure::String.id) {
+					return other->cstring_length () == num_bytes &&
+						   std::memcmp (data, other->cstring (), num_bytes) == 0;
+				}
+				return false;
+			}
+
+			bool equivalent (const weak<>& other) const override { return equal (other); }
+
+			int compare (const weak<>& other) const override {
+				if (pure::category_id (other) != pure::String.id) return pure::compare (cstring (), other);
+				return utf8::string_compare (data, num_bytes, other->cstring (), other->cstring_length ());
+			}
+
+			int equivalent_compare (const weak<>& other) const override { return compare (other); }
+
+			int64_t hash () const override {
+				return detail::hash_cstring_with_length (data, num_bytes);
+			}
+
+			/**
+			 Returns a pointer to the n-th code point, the end of the view if n is equal to the number of code points
+			 or nullptr if n is out of bounds.
+			 */
+			const char* code_point_position (intptr_t n) const {
+				if (n < 0) return nullptr;
+				const char* end = data + num_bytes;
+				const char* pos = data;
+				for (; n > 0; --n) {
+					if (pos == end) return nullptr;
+					pos = utf8::advance (pos);
+				}
+				return pos;
+			}
+
+			char32_t apply (intptr_t index) const {
+				auto pos = code_point_position (index);
+				if (pos && pos != data + num_bytes) return utf8::read_char (pos);
+				else throw operation_not_supported ();
+			}
+			var virtual_apply (const var& a0) const override { return apply (a0); }
+
+			bool lookup (const var& key, var* result) const override {
+				intptr_t n;
+				auto pos = detail::index_key (key, n) ? code_point_position (n) : nullptr;
+				if (!pos || pos == data + num_bytes) return false;
+				if (result) *result = utf8::read_char (pos);
+				return true;
+			}
+
+			intptr_t arity () const noexcept override { return 1; }
+			bool Variadic () const noexcept override { return false; }
+
+			/**
+			 Returns a view of the code points [start, end), sharing the owner of this view.
+			 */
+			immediate<String_View> slice (intptr_t start, intptr_t end) const {
+				auto begin_pos = code_point_position (start);
+				auto end_pos = begin_pos && end >= start ? code_point_position (end) : nullptr;
+				if (!end_pos) throw operation_not_supported ();
+				return slice_bytes (begin_pos, end_pos - begin_pos);
+			}
+
+			/**
+			 Returns a view of num_bytes bytes starting at position, which has to point into this view.
+			 */
+			immediate<String_View> slice_bytes (const char* position, intptr_t num_bytes) const {
+				assert (position >= data && position + num_bytes <= data + this->num_bytes);
+				return {owner, position, num_bytes, null_terminated && position + num_bytes == data + this->num_bytes};
+			}
+
+			struct enumerator : enumerator_base<char32_t> {
+				const char* position;
+				const char* end;
+
+				enumerator (const char* position, const char* end) : position {position}, end {end} {}
+
+				void next () noexcept { position = utf8::advance (position); }
+				bool empty () const noexcept { return position == end; }
+				char32_t read () const noexcept { return utf8::read_char (position); }
+				char32_t move () const noexcept { return read (); }
+			};
+
+			bool Enumerable () const noexcept override { return true; }
+
+			enumerator enumerate () const noexcept { return {data, data + num_bytes}; }
+			generic_enumerator virtual_enumerate () const override { return enumerate (); }
+
+			intptr_t count () const override { return utf8::count (data, num_bytes); }
+			bool Empty () const override { return num_bytes == 0; }
+
+			char32_t first () const { return apply (0); }
+			var virtual_first () const override { return first (); }
+
+			char32_t second () const { return apply (1); }
+			var virtual_second () const override { return second (); }
+
+			char32_t nth (intptr_t n) const { return apply (n); }
+			var virtual_nth (intptr_t n) const override { return nth (n); }
+
+			unique<String> append_persistent (const var&, char32_t c) const {
+				auto result = String::create_from_cstring (String::capacity_needed_for_length (num_bytes + 32), data,
+														   num_bytes);
+				result->append_char (c);
+				return result;
+			}
+			some<> virtual_append_persistent (const var& self, var&& element) const override {
+				return append_persistent ({}, std::move (element));
+			};
+
+			template<typename Stream>
+			void print_to (Stream& stream) const {
+				IO::print_to (stream, cstring ());
+			}
+			void virtual_print_to (var& stream) const override { this->print_to (stream); }
+		};
+	}
+}
@@ -23,12 +23,14 @@ namespace pure {
 			using vector_type = std::vector<element_type>;
 			using iterator_type = typename vector_type::const_iterator;
 			vector_type self;
+			detail::hash_cache cached_hash;
 
 			template<typename Other>
 			Vector (Other&& other) : self {} {
 				if constexpr (Trait_Enumerable<std::decay_t<Other>>::implemented) {
-					for (auto enumerator = pure::enumerate (
-							std::forward<Other> (other)); !enumerator.empty (); enumerator.next ()) {
+					auto enumerator = pure::enumerate (std::forward<Other> (other));
+					if (enumerator.has_size ()) self.reserve (enumerator.size ());
+					for (; !enumerator.empty (); enumerator.next ()) {
 						self.emplace_back (enumerator.move ());
 					}
 				}
@@ -52,9 +54,9 @@ namespace pure {
 				append_elements (std::forward<Args> (args)...);
 			}
 
-			Vector (Vector& other) : self (other.self) {};
-			Vector (const Vector& other) : self (other.self) {};
-			Vector (Vector&& other) : self (std::move (other.self)) {};
+			Vector (Vector& other) : self (other.self), cached_hash (other.cached_hash) {};
+			Vector (const Vector& other) : self (other.self), cached_hash (other.cached_hash) {};
+			Vector (Vector&& other) : self (std::move (other.self)), cached_hash (other.cached_hash) {};
 
 			Vector (const vector_type& other) : self (other) {};
 			Vector (vector_type&& other) : self (std::move (other)) {};
@@ -71,29 +73,49 @@ namespace pure {
 				return new (memory) Vector {std::move (*this)};
 			}
 
+			/**
+			 Returns other as a Vector of the same type or nullptr, which allows comparing the containers directly.
+			 */
+			static const Vector* same_type (const weak<>& other) {
+				return dynamic_cast<const Vector*> (other.operator-> ());
+			}
+
 			bool equal (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::equal_container (pure::equal, self, same->self);
 				return detail::equal_sequence (pure::equal, enumerate (), other);
 			}
 
 			bool equivalent (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::equal_container (pure::equivalent, self, same->self);
 				return detail::equal_sequence (pure::equivalent, enumerate (), other);
 			}
 
 			int compare (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::compare_container (pure::compare, self, same->self);
 				return detail::compare_sequence (pure::compare, enumerate (), other);
 			}
 
 			int equivalent_compare (const weak<>& other) const override {
+				if (auto same = same_type (other)) {
+					return detail::compare_container (pure::equivalent_compare, self, same->self);
+				}
 				return detail::compare_sequence (pure::equivalent_compare, enumerate (), other);
 			}
 
-			int32_t hash () const override {
-				return detail::hash_sequence (enumerate ());
+			int64_t hash () const override {
+				return cached_hash.get ([this] { return detail::hash_sequence (enumerate ()); });
 			}
 
-			const element_type& apply (intptr_t n) const { return self[n]; }
+			typename vector_type::const_reference apply (intptr_t n) const { return self[n]; }
 			var virtual_apply (const var& n) const override { return apply (n); }
 
+			bool lookup (const var& key, var* result) const override {
+				intptr_t n;
+				if (!detail::index_key (key, n) || n < 0 || n >= intptr_t (self.size ())) return false;
+				if (result) *result = self[n];
+				return true;
+			}
+
 			intptr_t arity () const noexcept override { return 1; }
 			bool Variadic () const noexcept override { return false; }
 
@@ -126,6 +148,7 @@ namespace pure {
 
 			template<typename Index, typename Value>
 			auto set_transient (var&&, const Index& index, Value&& value) {
+				cached_hash.reset ();
 				auto i = static_cast<typename vector_type::size_type>(index);
 				if constexpr (std::is_convertible_v<Value&&, element_type>) {
 					self[i] = (std::forward<Value> (value));
@@ -180,13 +203,13 @@ namespace pure {
 			intptr_t count () const noexcept override { return self.size (); }
 			bool Empty () const noexcept override { return self.empty (); }
 
-			const element_type& first () const { return nth (0); }
+			typename vector_type::const_reference first () const { return nth (0); }
 			var virtual_first () const override { return first (); }
 
-			const element_type& second () const { return nth (0); }
+			typename vector_type::const_reference second () const { return nth (0); }
 			var virtual_second () const override { return second (); }
 
-			const element_type& nth (intptr_t n) const { return self[n]; }
+			typename vector_type::const_reference nth (intptr_t n) const { return self[n]; }
 			var virtual_nth (intptr_t n) const override { return nth (n); }
 
 			template<typename Value>
@@ -213,6 +236,7 @@ namespace pure {
 
 			template<typename Value>
 			auto append_transient (const var&, Value&& value) {
+				cached_hash.reset ();
 				if constexpr (std::is_convertible_v<Value&&, element_type>) {
 					self.emplace_back (std::forward<Value> (value));
 					return immediate<Vector> {std::move (self)};
@@ -97,7 +97,7 @@ namespace pure {
 			else throw operation_not_supported ();
 		}
 
-		int32_t hash () const override {
+		int64_t hash () const override {
 			if constexpr (Trait_Hash<T>::implemented)
 				return pure::hash (get ());
 			else throw operation_not_supported ();
@@ -170,6 +170,13 @@ namespace pure {
 				throw operation_not_supported ();
 		}
 
+		bool lookup (const var& key, var* result) const override {
+			if constexpr (is_Functional)
+				return Trait_Functional<T>::lookup (get (), key, result);
+			else
+				throw operation_not_supported ();
+		}
+
 		intptr_t arity () const override {
 			if constexpr (is_Functional)
 				return pure::arity (get ());
@@ -44,7 +44,8 @@ namespace pure {
 			void operator delete (void* p) {::operator delete (p, std::align_val_t {16});}
 
 			void* operator new (std::size_t, void* p) { return p; }
-			void operator delete (void* p, void*) {::operator delete (p, std::align_val_t {16});}
+			// Called, if a constructor throws during placement new. The memory doesn't belong to the value.
+			void operator delete (void*, void*) {}
 
 			void* operator new (std::size_t, sized_allocation_t, std::size_t num_bytes) { return ::operator new (num_bytes, std::align_val_t {16}); }
 			void operator delete (void* p, sized_allocation_t, std::size_t num_bytes) {::operator delete (p, num_bytes, std::align_val_t {16});}
@@ -80,7 +81,7 @@ namespace pure {
 			virtual int compare (const weak<Value, never_nil>& other) const { throw operation_not_supported (); }
 			virtual int equivalent_compare (const weak<Value, never_nil>& other) const { return compare (other); }
 
-			virtual int32_t hash () const { throw operation_not_supported (); }
+			virtual int64_t hash () const { throw operation_not_supported (); }
 
 			virtual var virtual_apply () const { throw operation_not_supported (); }
 			virtual var virtual_apply (const var&) const { throw operation_not_supported (); }
@@ -90,6 +91,12 @@ namespace pure {
 			template<typename... Args>
 			var apply (Args&& ... args) const { return virtual_apply (std::forward<Args> (args)...); }
 
+			/**
+			 Non-throwing counterpart of apply with one argument. Returns false, if key isn't in the domain of this
+			 value. Otherwise stores the value for key in result, unless result is nullptr, and returns true.
+			 */
+			virtual bool lookup (const var& key, var* result) const { throw operation_not_supported (); }
+
 			virtual intptr_t arity () const { throw operation_not_supported (); }
 			virtual bool Variadic () const noexcept { return false; }
 
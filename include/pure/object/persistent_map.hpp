@@ -18,7 +18,20 @@ namespace pure {
 
 	struct hash_t {
 		template<typename T>
-		int32_t operator() (const T& self) { return pure::hash (self); }
+		int64_t operator() (const T& self) { return pure::hash (self); }
+	};
+
+	/**
+	 Hash function for maps, whose keys come from untrusted input. Keys are hashed with a key drawn randomly at
+	 process start, so that collisions can't be precomputed. That holds for strings, numbers and vectors, maps and
+	 records of them. Other values keep the collisions of their unkeyed hash. Costs more than hash_t, see
+	 test/hash-benchmark.cpp.
+	 The keyed hash isn't cached like pure::hash, so vector and map keys are enumerated again on every insert and
+	 lookup, which costs time linear in the size of the key.
+	 */
+	struct keyed_hash_t {
+		template<typename T>
+		int64_t operator() (const T& self) { return detail::keyed_hash (self, detail::siphash::process_key ()); }
 	};
 }
 
@@ -31,16 +44,18 @@ namespace pure {
 		 Persistent Map implementation using immer library. Has constant time persistent set
 		 @tparam Key Type for keys
 		 @tparam Val Type for values
+		 @tparam Hash Hash function for keys. keyed_hash_t protects maps built from untrusted input against collisions.
 		 */
-		template<typename Key, typename Val>
+		template<typename Key, typename Val, typename Hash = hash_t>
 		struct Map : Interface::Value {
 			using domain_t = Function_t<pure::domain_t<Key>, pure::domain_t<Val>>;
 			using key_type = Key;
 			using value_type = Val;
-			using map_type = immer::map<key_type, value_type, hash_t, equal_t>;
+			using map_type = immer::map<key_type, value_type, Hash, equal_t>;
 			using pair_type = typename map_type::value_type;
 			using iterator_type = typename map_type::const_iterator;
 			map_type self;
+			detail::hash_cache cached_hash;
 
 			template<typename Other>
 			Map (Other&& other) : self {} {
@@ -75,9 +90,9 @@ namespace pure {
 				insert_elements (std::forward<Args> (args)...);
 			}
 
-			Map (Map& other) : self {other.self} {};
-			Map (const Map& other) : self {other.self} {};
-			Map (Map&& other) : self {std::move (other.self)} {};
+			Map (Map& other) : self {other.self}, cached_hash {other.cached_hash} {};
+			Map (const Map& other) : self {other.self}, cached_hash {other.cached_hash} {};
+			Map (Map&& other) : self {std::move (other.self)}, cached_hash {other.cached_hash} {};
 
 			Map (const map_type& other) : self {other} {};
 			Map (map_type&& other) : self {std::move (other)} {};
@@ -94,22 +109,49 @@ namespace pure {
 				return new (memory) Map {std::move (*this)};
 			}
 
+			/**
+			 Returns other as a Map of the same type or nullptr, which allows comparing the containers directly.
+			 */
+			static const Map* same_type (const weak<>& other) {
+				return dynamic_cast<const Map*> (other.operator-> ());
+			}
+
 			bool equal (const weak<>& other) const override {
-				return detail::equal_map (pure::equal, enumerate (), count (), other);
+				if (auto same = same_type (other)) return detail::equal_map_container (pure::equal, self, same->self);
+				return detail::equal_map (pure::equal, *this, other);
 			}
 
 			bool equivalent (const weak<>& other) const override {
-				return detail::equal_map (pure::equivalent, enumerate (), count (), other);
+				if (auto same = same_type (other)) return detail::equal_map_container (pure::equivalent, self, same->self);
+				return detail::equal_map (pure::equivalent, *this, other);
 			}
 
-			int32_t hash () const override {
-				return detail::hash_map (enumerate ());
+			int64_t hash () const override {
+				return cached_hash.get ([this] { return detail::hash_map (enumerate ()); });
 			}
 
 			template<typename K>
 			const value_type& apply (const K& key) const { return self.at (key); }
+
+			/**
+			 Returns a pointer to the value for key or nullptr, if key isn't in the map. Keys outside the domain of
+			 key_type are never converted to it, so they don't throw.
+			 */
+			template<typename K>
+			const value_type* find (const K& key) const {
+				if constexpr (std::is_convertible_v<const K&, key_type>) {
+					if (pure::domain_t<key_type> {} (key)) return self.find (key);
+				}
+				return nullptr;
+			}
 			var virtual_apply (const var& key) const override { return apply (key); }
 
+			bool lookup (const var& key, var* result) const override {
+				auto found = find (key);
+				if (found && result) *result = *found;
+				return found != nullptr;
+			}
+
 			intptr_t arity () const noexcept override { return 1; }
 			bool Variadic () const noexcept override { return false; }
 
@@ -123,6 +165,7 @@ namespace pure {
 
 			template<typename K, typename V>
 			immediate <Map> set_transient (const var&, K&& key, V&& value) {
+				cached_hash.reset ();
 				return std::move (self).set (std::forward<K> (key), std::forward<V> (value));
 			};
 
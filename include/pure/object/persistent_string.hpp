@@ -0,0 +1,388 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/object/interface.hpp>
+#include <pure/object/basic_string.hpp>
+#include <pure/support/enumerator.hpp>
+#include <pure/support/utf8.hpp>
+#include <pure/impl/Trait_Compare.hpp>
+#include <pure/impl/Trait_Hash.hpp>
+#include <pure/impl/Trait_Print.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace pure::detail::rope {
+	struct node;
+	using node_ptr = std::shared_ptr<const node>;
+
+	/**
+	 Immutable node of an AVL balanced rope. Leaves hold a chunk of text, branches the concatenation of their
+	 children.
+	 */
+	struct node {
+		node_ptr left;
+		node_ptr right;
+		unique<Basic::String, maybe_nil> text;
+		intptr_t num_bytes;
+		intptr_t num_code_points;
+		intptr_t height;
+
+		bool leaf () const noexcept { return !left; }
+	};
+
+	// Leaves are merged on append, as long as the result doesn't exceed this size.
+	static constexpr intptr_t max_leaf_bytes = 512;
+
+	inline intptr_t height (const node_ptr& n) { return n ? n->height : -1; }
+	inline intptr_t num_bytes (const node_ptr& n) { return n ? n->num_bytes : 0; }
+	inline intptr_t num_code_points (const node_ptr& n) { return n ? n->num_code_points : 0; }
+
+	inline node_ptr make_leaf (const char* str, intptr_t num_bytes) {
+		if (num_bytes == 0) return nullptr;
+		auto text = Basic::String::create_from_cstring (Basic::String::capacity_needed_for_length (num_bytes), str,
+														 num_bytes);
+		auto num_code_points = utf8::count (str, num_bytes);
+		return std::make_shared<const node> (node {nullptr, nullptr, std::move (text), num_bytes, num_code_points, 0});
+	}
+
+	inline node_ptr make_branch (node_ptr left, node_ptr right) {
+		auto bytes = left->num_bytes + right->num_bytes;
+		auto code_points = left->num_code_points + right->num_code_points;
+		auto h = 1 + std::max (left->height, right->height);
+		return std::make_shared<const node> (node {std::move (left), std::move (right), nullptr, bytes, code_points, h});
+	}
+
+	inline node_ptr make_balanced (const std::vector<node_ptr>& leaves, size_t begin, size_t end) {
+		if (end - begin == 1) return leaves[begin];
+		auto middle = begin + (end - begin) / 2;
+		return make_branch (make_balanced (leaves, begin, middle), make_balanced (leaves, middle, end));
+	}
+
+	/**
+	 Builds a balanced rope from num_bytes bytes of str, cut into leaves of at most max_leaf_bytes. Leaves are
+	 cut at code point boundaries.
+	 */
+	inline node_ptr make_rope (const char* str, intptr_t num_bytes) {
+		if (num_bytes <= max_leaf_bytes) return make_leaf (str, num_bytes);
+		std::vector<node_ptr> leaves;
+		const char* end = str + num_bytes;
+		while (str != end) {
+			auto cut = end - str > max_leaf_bytes ? str + max_leaf_bytes : end;
+			while (cut != end && cut != str && utf8::detail::is_continuation_byte (*cut)) --cut;
+			if (cut == str) cut = str + max_leaf_bytes;
+			leaves.push_back (make_leaf (str, cut - str));
+			str = cut;
+		}
+		return make_balanced (leaves, 0, leaves.size ());
+	}
+
+	inline node_ptr rotate_left (const node_ptr& n) {
+		return make_branch (make_branch (n->left, n->right->left), n->right->right);
+	}
+
+	inline node_ptr rotate_right (const node_ptr& n) {
+		return make_branch (n->left->left, make_branch (n->left->right, n->right));
+	}
+
+	inline node_ptr rebalance (node_ptr n) {
+		auto balance = height (n->right) - height (n->left);
+		if (balance > 1) {
+			if (height (n->right->left) > height (n->right->right))
+				n = make_branch (n->left, rotate_right (n->right));
+			return rotate_left (n);
+		}
+		if (balance < -1) {
+			if (height (n->left->right) > height (n->left->left))
+				n = make_branch (rotate_left (n->left), n->right);
+			return rotate_right (n);
+		}
+		return n;
+	}
+
+	/**
+	 Concatenates two ropes in O(|height (l) - height (r)|), keeping the result balanced.
+	 */
+	inline node_ptr join (const node_ptr& l, const node_ptr& r) {
+		if (!l) return r;
+		if (!r) return l;
+		if (l->height > r->height + 1) return rebalance (make_branch (l->left, join (l->right, r)));
+		if (r->height > l->height + 1) return rebalance (make_branch (join (l, r->left), r->right));
+		return make_branch (l, r);
+	}
+
+	/**
+	 Splits a rope into the first n code points and the rest in O(log n).
+	 */
+	inline std::pair<node_ptr, node_ptr> split (const node_ptr& self, intptr_t n) {
+		if (!self || n <= 0) return {nullptr, self};
+		if (n >= self->num_code_points) return {self, nullptr};
+		if (self->leaf ()) {
+			auto& text = *self->text;
+			auto pos = text.code_point_position (n);
+			return {make_leaf (text.str, pos - text.str), make_leaf (pos, text.str_end - pos)};
+		}
+		auto left_count = self->left->num_code_points;
+		if (n < left_count) {
+			auto [a, b] = split (self->left, n);
+			return {a, join (b, self->right)};
+		}
+		auto [a, b] = split (self->right, n - left_count);
+		return {join (self->left, a), b};
+	}
+
+	/**
+	 Appends num_bytes bytes of str. Merges into the rightmost leaf, if it stays below max_leaf_bytes.
+	 */
+	inline node_ptr append (const node_ptr& self, const char* str, intptr_t num_bytes) {
+		if (!self) return make_rope (str, num_bytes);
+		if (self->leaf ()) {
+			if (self->num_bytes + num_bytes > max_leaf_bytes) return join (self, make_rope (str, num_bytes));
+			auto merged = Basic::String::create_empty (
+					Basic::String::capacity_needed_for_length (self->num_bytes + num_bytes));
+			merged->append_cstring (self->text->str, self->num_bytes);
+			merged->append_cstring (str, num_bytes);
+			auto code_points = self->num_code_points + utf8::count (str, num_bytes);
+			auto bytes = self->num_bytes + num_bytes;
+			return std::make_shared<const node> (node {nullptr, nullptr, std::move (merged), bytes, code_points, 0});
+		}
+		auto right = append (self->right, str, num_bytes);
+		if (right->height == self->right->height) return make_branch (self->left, std::move (right));
+		return rebalance (make_branch (self->left, std::move (right)));
+	}
+
+	/**
+	 Returns the leaf containing code point n together with the index of n inside that leaf.
+	 */
+	inline std::pair<const node*, intptr_t> find (const node* self, intptr_t n) {
+		while (!self->leaf ()) {
+			auto left_count = self->left->num_code_points;
+			if (n < left_count) self = self->left.get ();
+			else {
+				n -= left_count;
+				self = self->right.get ();
+			}
+		}
+		return {self, n};
+	}
+
+	template<typename Fn>
+	void for_each_leaf (const node* self, Fn&& fn) {
+		if (!self) return;
+		if (self->leaf ()) fn (*self->text);
+		else {
+			for_each_leaf (self->left.get (), fn);
+			for_each_leaf (self->right.get (), fn);
+		}
+	}
+}
+
+namespace pure {
+	namespace Persistent {
+		/**
+		 Persistent string implemented as a balanced rope of Basic::String chunks. append, set, slice and concat
+		 share structure with the original and take O(log n). The flat representation needed by cstring () is built
+		 lazily and cached.
+		 */
+		struct String : Interface::Value {
+			using domain_t = String_t;
+			using node_ptr = detail::rope::node_ptr;
+
+			node_ptr root;
+			mutable std::atomic<Basic::String*> flat {nullptr};
+
+			String () = default;
+			String (node_ptr root) : root {std::move (root)} {}
+			String (String& other) : root {other.root} {}
+			String (const String& other) : root {other.root} {}
+			String (String&& other) : root {std::move (other.root)} {}
+
+			template<typename Other>
+			String (const Other& other) :
+					root {detail::rope::make_rope (pure::raw_cstring (other), pure::raw_cstring_length (other))} {}
+
+			~String () override { delete flat.load (std::memory_order_relaxed); }
+
+			int category_id () const noexcept override { return pure::String.id; }
+
+			Interface::Value* clone () const& override { return new String {*this}; }
+			Interface::Value* clone ()&& override { return new String {std::move (*this)}; }
+			intptr_t clone_bytes_needed () const override { return sizeof (String); }
+			Interface::Value* clone_placement (void* memory, intptr_t num_bytes) const& override {
+				return new (memory) String {*this};
+			}
+			Interface::Value* clone_placement (void* memory, intptr_t num_bytes)&& override {
+				return new (memory) String {std::move (*this)};
+			}
+
+			const char* cstring () const override {
+				if (auto result = flat.load (std::memory_order_acquire)) return result->str;
+
+				auto result = Basic::String::create_empty (
+						Basic::String::capacity_needed_for_length (cstring_length ())).release ();
+				detail::rope::for_each_leaf (root.get (), [result] (const Basic::String& leaf) {
+					result->append_cstring (leaf.str, leaf.cstring_length ());
+				});
+
+				Basic::String* expected = nullptr;
+				if (flat.compare_exchange_strong (expected, result, std::memory_order_acq_rel)) return result->str;
+				delete result;
+				return expected->str;
+			}
+
+			intptr_t cstring_length () const override { return detail::rope::num_bytes (root); }
+
+			bool equal (const weak<>& other) const override {
+				if (pure::category_id (other) == pure::String.id) {
+					return pure::equal (cstring (), other->cstring ());
+				}
+				return false;
+			}
+
+			bool equivalent (const weak<>& other) const override { return equal (other); }
+
+			int compare (const weak<>& other) const override {
+				return pure::compare (cstring (), other);
+			}
+
+			int equivalent_compare (const weak<>& other) const override {
+				return pure::equivalent_compare (cstring (), other);
+			}
+
+			int64_t hash () const override {
+				if (auto result = flat.load (std::memory_order_acquire)) {
+					return detail::hash_cstring_with_length (result->str, result->cstring_length ());
+				}
+				hasher result;
+				detail::rope::for_each_leaf (root.get (), [&result] (const Basic::String& leaf) {
+					result.update (leaf.str, leaf.cstring_length ());
+				});
+				return result.finish ();
+			}
+
+			char32_t apply (intptr_t index) const {
+				if (index < 0 || index >= count ()) throw operation_not_supported ();
+				auto [leaf, n] = detail::rope::find (root.get (), index);
+				return leaf->text->nth (n);
+			}
+			var virtual_apply (const var& a0) const override { return apply (a0); }
+
+			bool lookup (const var& key, var* result) const override {
+				intptr_t n;
+				if (!detail::index_key (key, n) || n < 0 || n >= count ()) return false;
+				if (result) *result = apply (n);
+				return true;
+			}
+
+			intptr_t arity () const noexcept override { return 1; }
+			bool Variadic () const noexcept override { return false; }
+
+			/**
+			 Returns the code points [start, end) of this string.
+			 */
+			immediate<String> slice (intptr_t start, intptr_t end) const {
+				if (start < 0 || start > end || end > count ()) throw operation_not_supported ();
+				auto head = detail::rope::split (root, end).first;
+				return detail::rope::split (head, start).second;
+			}
+
+			/**
+			 Returns the concatenation of this string and other.
+			 */
+			immediate<String> concat (const String& other) const {
+				return detail::rope::join (root, other.root);
+			}
+
+			/**
+			 Replaces the code point at index with c. Appends c, if index is equal to count (), and throws
+			 operation_not_supported for any other index out of bounds.
+			 */
+			immediate<String> set_persistent (const var&, intptr_t index, char32_t c) const {
+				if (index < 0 || index > count ()) throw operation_not_supported ();
+				char buffer[4];
+				auto buffer_end = utf8::write_char (buffer, c);
+				auto [head, tail] = detail::rope::split (root, index);
+				auto rest = detail::rope::split (tail, 1).second;
+				return detail::rope::join (detail::rope::append (head, buffer, buffer_end - buffer), rest);
+			};
+			some<> virtual_set_persistent (const var&, var&& key, var&& value) const override {
+				return set_persistent ({}, key, value);
+			}
+
+			bool Enumerable () const noexcept override { return true; }
+
+			struct enumerator : enumerator_base<char32_t> {
+				std::vector<const detail::rope::node*> stack;
+				const char* position = nullptr;
+
+				enumerator (const node_ptr& root) {
+					push_left (root.get ());
+					next_leaf ();
+				}
+
+				void push_left (const detail::rope::node* n) {
+					for (; n; n = n->leaf () ? nullptr : n->left.get ()) stack.push_back (n);
+				}
+
+				void next_leaf () {
+					position = nullptr;
+					while (!stack.empty () && !position) {
+						auto n = stack.back ();
+						stack.pop_back ();
+						if (n->leaf ()) position = n->text->str;
+						else push_left (n->right.get ());
+					}
+				}
+
+				void next () {
+					position = utf8::advance (position);
+					if (*position == '\0') next_leaf ();
+				}
+				bool empty () const noexcept { return !position; }
+				char32_t read () const noexcept { return utf8::read_char (position); }
+				char32_t move () const noexcept { return read (); }
+			};
+
+			enumerator enumerate () const { return {root}; }
+			generic_enumerator virtual_enumerate () const override { return enumerate (); }
+
+			intptr_t count () const noexcept override { return detail::rope::num_code_points (root); }
+			bool Empty () const noexcept override { return !root; }
+
+			char32_t first () const { return apply (0); }
+			var virtual_first () const override { return first (); }
+
+			char32_t second () const { return apply (1); }
+			var virtual_second () const override { return second (); }
+
+			char32_t nth (intptr_t n) const { return apply (n); }
+			var virtual_nth (intptr_t n) const override { return nth (n); }
+
+			immediate<String> append_persistent (const var&, char32_t c) const {
+				char buffer[4];
+				auto buffer_end = utf8::write_char (buffer, c);
+				return detail::rope::append (root, buffer, buffer_end - buffer);
+			}
+			some<> virtual_append_persistent (const var& self, var&& element) const override {
+				return append_persistent ({}, std::move (element));
+			};
+
+			/**
+			 Appends num_bytes bytes of the utf8 string str.
+			 */
+			immediate<String> append_cstring (const char* str, intptr_t num_bytes) const {
+				return detail::rope::append (root, str, num_bytes);
+			}
+
+			template<typename Stream>
+			void print_to (Stream& stream) const {
+				detail::rope::for_each_leaf (root.get (), [&stream] (const Basic::String& leaf) {
+					IO::print_to (stream, leaf.cstring ());
+				});
+			}
+			void virtual_print_to (var& stream) const override { this->print_to (stream); }
+		};
+	}
+}
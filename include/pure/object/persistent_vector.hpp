@@ -24,6 +24,7 @@ namespace pure {
 			using vector_type = immer::vector<element_type>;
 			using iterator_type = typename vector_type::const_iterator;
 			vector_type self;
+			detail::hash_cache cached_hash;
 
 			template<typename Other>
 			Vector (Other&& other) : self {} {
@@ -52,9 +53,9 @@ namespace pure {
 				append_elements (std::forward<Args> (args)...);
 			}
 
-			Vector (Vector& other) : self (other.self) {};
-			Vector (const Vector& other) : self (other.self) {};
-			Vector (Vector&& other) : self (std::move (other.self)) {};
+			Vector (Vector& other) : self (other.self), cached_hash (other.cached_hash) {};
+			Vector (const Vector& other) : self (other.self), cached_hash (other.cached_hash) {};
+			Vector (Vector&& other) : self (std::move (other.self)), cached_hash (other.cached_hash) {};
 
 			Vector (const vector_type& other) : self (other) {};
 			Vector (vector_type&& other) : self (std::move (other)) {};
@@ -71,29 +72,49 @@ namespace pure {
 				return new (memory) Vector {std::move (*this)};
 			}
 
+			/**
+			 Returns other as a Vector of the same type or nullptr, which allows comparing the containers directly.
+			 */
+			static const Vector* same_type (const weak<>& other) {
+				return dynamic_cast<const Vector*> (other.operator-> ());
+			}
+
 			bool equal (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::equal_container (pure::equal, self, same->self);
 				return detail::equal_sequence (pure::equal, enumerate (), other);
 			}
 
 			bool equivalent (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::equal_container (pure::equivalent, self, same->self);
 				return detail::equal_sequence (pure::equivalent, enumerate (), other);
 			}
 
 			int compare (const weak<>& other) const override {
+				if (auto same = same_type (other)) return detail::compare_container (pure::compare, self, same->self);
 				return detail::compare_sequence (pure::compare, enumerate (), other);
 			}
 
 			int equivalent_compare (const weak<>& other) const override {
+				if (auto same = same_type (other)) {
+					return detail::compare_container (pure::equivalent_compare, self, same->self);
+				}
 				return detail::compare_sequence (pure::equivalent_compare, enumerate (), other);
 			}
 
-			int32_t hash () const override {
-				return detail::hash_sequence (enumerate ());
+			int64_t hash () const override {
+				return cached_hash.get ([this] { return detail::hash_sequence (enumerate ()); });
 			}
 
 			const element_type& apply (intptr_t n) const { return self[n]; }
 			var virtual_apply (const var& n) const override { return apply (n); }
 
+			bool lookup (const var& key, var* result) const override {
+				intptr_t n;
+				if (!detail::index_key (key, n) || n < 0 || n >= intptr_t (self.size ())) return false;
+				if (result) *result = self[n];
+				return true;
+			}
+
 			intptr_t arity () const noexcept override { return 1; }
 			bool Variadic () const noexcept override { return false; }
 
@@ -107,6 +128,7 @@ namespace pure {
 
 			template<typename Index, typename Value>
 			immediate<Vector> set_transient (const var&, const Index& index, Value&& value) {
+				cached_hash.reset ();
 				return std::move (self).set (index, std::forward<Value> (value));
 			};
 
@@ -163,6 +185,7 @@ namespace pure {
 
 			template<typename Value>
 			immediate<Vector> append_transient (const var&, Value&& value) {
+				cached_hash.reset ();
 				return std::move (self).push_back (std::forward<Value> (value));
 			}
 			maybe<> virtual_append_transient (var&& self, var&& element) override {
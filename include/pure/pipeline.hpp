@@ -0,0 +1,154 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/types/var.hpp>
+#include <pure/support/channel.hpp>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace pure {
+	/**
+	 Pipeline stage, which applies fn to each item on multiple threads in parallel.
+	 */
+	template<typename Fn>
+	struct parallel_stage {
+		intptr_t parallelism;
+		Fn fn;
+	};
+
+	/**
+	 Returns a pipeline stage for pipe, which runs fn on parallelism threads. Items may leave the stage in a different
+	 order than they entered it.
+	 @param parallelism Number of worker threads
+	 @param fn A function of arity 1, which must be safe to call concurrently
+	 */
+	template<typename Fn>
+	auto parallel (intptr_t parallelism, Fn&& fn) {
+		if (parallelism <= 0) throw operation_not_supported ();
+		return parallel_stage<Fn> {parallelism, std::forward<Fn> (fn)};
+	}
+
+	namespace detail {
+		static constexpr intptr_t pipeline_channel_capacity = 64;
+
+		template<typename T>
+		struct is_parallel_stage : std::false_type {};
+
+		template<typename Fn>
+		struct is_parallel_stage<parallel_stage<Fn>> : std::true_type {};
+
+		template<typename Stage>
+		intptr_t stage_parallelism (const Stage& stage) {
+			if constexpr (is_parallel_stage<std::decay_t<Stage>>::value) return stage.parallelism;
+			else return 1;
+		}
+
+		template<typename Stage>
+		const auto& stage_function (const Stage& stage) {
+			if constexpr (is_parallel_stage<std::decay_t<Stage>>::value) return stage.fn;
+			else return stage;
+		}
+
+		struct pipeline {
+			std::vector<std::unique_ptr<channel>> channels;
+			std::vector<std::thread> threads;
+			std::mutex error_mutex;
+			std::exception_ptr error;
+
+			~pipeline () { join (); }
+
+			template<typename Fn>
+			void spawn (Fn&& fn) {
+				threads.emplace_back ([this, fn = std::forward<Fn> (fn)] () mutable {
+					try { fn (); }
+					catch (...) { fail (std::current_exception ()); }
+				});
+			}
+
+			// Records the first error and aborts all channels, so that every thread finishes as soon as possible.
+			void fail (std::exception_ptr e) {
+				{
+					std::lock_guard<std::mutex> lock {error_mutex};
+					if (!error) error = e;
+				}
+				for (auto& c : channels) c->abort ();
+			}
+
+			void join () {
+				for (auto& thread : threads) if (thread.joinable ()) thread.join ();
+			}
+		};
+
+		template<typename Source, typename Stages, typename Sink, size_t... Indices>
+		void run_pipeline (Source&& source, const Stages& stages, Sink&& sink, std::index_sequence<Indices...>) {
+			pipeline p;
+			p.channels.emplace_back (std::make_unique<channel> (pipeline_channel_capacity));
+			(p.channels.emplace_back (std::make_unique<channel> (
+					pipeline_channel_capacity, stage_parallelism (std::get<Indices> (stages)))), ...);
+
+			try {
+				p.spawn ([&source, out = p.channels.front ().get ()] {
+					for (auto e = pure::enumerate (source); !e.empty (); e.next ()) {
+						if (!out->push (e.move ())) break;
+					}
+					out->close ();
+				});
+
+				auto spawn_stage = [&p] (intptr_t index, const auto& stage) {
+					const auto& fn = stage_function (stage);
+					auto in = p.channels[index].get ();
+					auto out = p.channels[index + 1].get ();
+					for (intptr_t i = 0; i < stage_parallelism (stage); ++i) {
+						p.spawn ([&fn, in, out] {
+							var value;
+							while (in->pop (value)) {
+								if (!out->push (pure::apply (fn, std::move (value)))) break;
+							}
+							out->close ();
+						});
+					}
+				};
+				(spawn_stage (Indices, std::get<Indices> (stages)), ...);
+
+				var value;
+				while (p.channels.back ()->pop (value)) {
+					pure::apply (sink, std::move (value));
+				}
+			}
+			catch (...) {
+				p.fail (std::current_exception ());
+			}
+
+			p.join ();
+			if (p.error) std::rethrow_exception (p.error);
+		}
+
+		template<typename Source, typename Args, size_t... Indices>
+		void pipe (Source&& source, const Args& args, std::index_sequence<Indices...> stage_indices) {
+			constexpr size_t sink_index = std::tuple_size_v<Args> - 1;
+			run_pipeline (std::forward<Source> (source), std::forward_as_tuple (std::get<Indices> (args)...),
+						  std::get<sink_index> (args), stage_indices);
+		}
+	}
+
+	/**
+	 Streams the items of source through each stage and finally calls sink with every result. Every stage runs on its
+	 own threads, connected by bounded channels, so parsing, transformation and output overlap, while the number of
+	 items in flight stays bounded. A stage is either a function of arity 1 or parallel (n, f) to run f on n threads.
+	 sink is called on the calling thread. pipe returns once all items have been processed and rethrows the first
+	 exception thrown by any stage.
+	 @param source An enumerable value
+	 @param stages_and_sink Zero or more stages, followed by the sink
+	 */
+	template<typename Source, typename... Stages_And_Sink>
+	void pipe (Source&& source, Stages_And_Sink&& ... stages_and_sink) {
+		static_assert (sizeof... (Stages_And_Sink) >= 1, "pipe requires a sink");
+		detail::pipe (std::forward<Source> (source), std::forward_as_tuple (stages_and_sink...),
+					  std::make_index_sequence<sizeof... (Stages_And_Sink) - 1> {});
+	}
+}
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/types/var.hpp>
+#include <pure/types/immediate.hpp>
+#include <pure/types/shared.hpp>
+#include <pure/object/basic_string_view.hpp>
+#include <pure/support/enumerator.hpp>
+#include <pure/support/hashing.hpp>
+#include <pure/impl/Trait_Compare.hpp>
+#include <pure/impl/Trait_Hash.hpp>
+#include <pure/impl/Trait_Print.hpp>
+#include <pure/binary.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined (_WIN32)
+#include <pure/functions.hpp>
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ Read-only values backed by a memory mapped snapshot file. A snapshot consists of snapshot_magic followed by one value
+ in the format described in pure/binary.hpp. Opening a snapshot only maps the file and checks the header of the root
+ value. Vectors and maps are decoded lazily on access, strings refer to the mapped bytes and the pages of the file are
+ shared by all processes, which map it.
+ */
+namespace pure::Mapped {
+	constexpr char snapshot_magic[8] = {'p', 'u', 'r', 'e', '-', 's', 'n', 'p'};
+
+	using owner_t = shared<Interface::Value, maybe_nil>;
+
+	/**
+	 Read-only mapping of a whole file, which is unmapped once the last value referring to it is destroyed. Reads the
+	 file into memory on platforms without mmap. Also owns the lookup indexes of the vectors and maps in the file.
+	 */
+	struct File : Interface::Value {
+		const char* data = nullptr;
+		intptr_t num_bytes = 0;
+
+		mutable std::mutex index_mutex;
+		// Indexes keyed by the position of their container, so each one is built once per mapping.
+		mutable std::unordered_map<const char*, std::shared_ptr<const void>> indexes;
+
+		File (const char* path) {
+			#if defined (_WIN32)
+				auto stream = IO::fopen (path, "rb");
+				if (std::fseek (stream, 0, SEEK_END)) throw operation_not_supported ();
+				num_bytes = std::ftell (stream);
+				if (num_bytes < 0 || std::fseek (stream, 0, SEEK_SET)) throw operation_not_supported ();
+				auto buffer = new char[num_bytes + 1];
+				if (std::fread (buffer, 1, num_bytes, stream) != size_t (num_bytes)) {
+					delete[] buffer;
+					throw operation_not_supported ();
+				}
+				data = buffer;
+			#else
+				int fd = ::open (path, O_RDONLY);
+				if (fd < 0) throw operation_not_supported ();
+				struct stat info;
+				if (::fstat (fd, &info) != 0) {
+					::close (fd);
+					throw operation_not_supported ();
+				}
+				num_bytes = static_cast<intptr_t> (info.st_size);
+				if (num_bytes > 0) {
+					auto memory = ::mmap (nullptr, num_bytes, PROT_READ, MAP_SHARED, fd, 0);
+					if (memory == MAP_FAILED) {
+						::close (fd);
+						throw operation_not_supported ();
+					}
+					data = static_cast<const char*> (memory);
+				}
+				// The mapping stays valid after the file is closed.
+				::close (fd);
+			#endif
+		}
+
+		~File () override {
+			#if defined (_WIN32)
+				delete[] data;
+			#else
+				if (data) ::munmap (const_cast<char*> (data), num_bytes);
+			#endif
+		}
+
+		/**
+		 Returns the index of the container at position or stores the one returned by build, if there's none yet.
+		 */
+		template<typename Index, typename Build>
+		const Index& index (const char* position, Build&& build) const {
+			{
+				std::lock_guard<std::mutex> lock {index_mutex};
+				auto found = indexes.find (position);
+				if (found != indexes.end ()) return *static_cast<const Index*> (found->second.get ());
+			}
+			std::shared_ptr<const void> index = std::make_shared<const Index> (build ());
+			std::lock_guard<std::mutex> lock {index_mutex};
+			auto inserted = indexes.emplace (position, std::move (index)).first;
+			return *static_cast<const Index*> (inserted->second.get ());
+		}
+	};
+
+	namespace detail {
+		/**
+		 Returns the encoded value as var. Strings of up to 7 bytes are copied into var, longer ones and ones containing
+		 a null byte become views of the mapped bytes. Vectors and maps become Mapped::Vector and Mapped::Map, which share the owner.
+		 */
+		inline var value (const owner_t& owner, binary::view self, intptr_t depth);
+
+		inline int64_t key_hash (binary::view key) {
+			if (key.tag () != binary::Tag::String) return pure::hash (key.decode ());
+			intptr_t length;
+			auto str = key.get_string (length);
+			return pure::detail::hash_cstring_with_length (str, length);
+		}
+	}
+
+	/**
+	 Vector, whose items are decoded on access. nth and apply skip at most index_stride items from the closest entry
+	 of an index, which is built on first use and shared through the file by all objects for the same vector.
+	 */
+	struct Vector : Interface::Value {
+		using domain_t = Vector_t<Any_t>;
+
+		// Position of every index_stride-th item.
+		using item_index_t = std::vector<const char*>;
+		static constexpr intptr_t index_stride = 64;
+
+		owner_t owner;
+		binary::view self;
+		// Number of containers around this one, which is limited to binary::max_depth.
+		intptr_t depth;
+		pure::detail::hash_cache cached_hash;
+		mutable std::atomic<const item_index_t*> item_index {nullptr};
+
+		/**
+		 owner has to be the Mapped::File containing value.
+		 */
+		Vector (owner_t owner, binary::view value, intptr_t depth) :
+				owner {std::move (owner)}, self {value.data, value.num_bytes ()}, depth {depth} {
+			if (value.tag () != binary::Tag::Vector || depth >= binary::max_depth) throw operation_not_supported ();
+		}
+
+		Vector (const Vector& other) :
+				owner {other.owner}, self {other.self}, depth {other.depth}, cached_hash {other.cached_hash},
+				item_index {other.item_index.load (std::memory_order_acquire)} {}
+
+		int category_id () const noexcept override { return Any_Vector.id; }
+
+		Interface::Value* clone () const& override { return new Vector {*this}; }
+		intptr_t clone_bytes_needed () const override { return sizeof (Vector); }
+		Interface::Value* clone_placement (void* memory, intptr_t num_bytes) const& override {
+			return new (memory) Vector {*this};
+		}
+
+		bool equal (const weak<>& other) const override {
+			return pure::detail::equal_sequence (pure::equal, enumerate (), other);
+		}
+
+		bool equivalent (const weak<>& other) const override {
+			return pure::detail::equal_sequence (pure::equivalent, enumerate (), other);
+		}
+
+		int compare (const weak<>& other) const override {
+			return pure::detail::compare_sequence (pure::compare, enumerate (), other);
+		}
+
+		int equivalent_compare (const weak<>& other) const override {
+			return pure::detail::compare_sequence (pure::equivalent_compare, enumerate (), other);
+		}
+
+		int64_t hash () const override {
+			return cached_hash.get ([this] { return pure::detail::hash_sequence (enumerate ()); });
+		}
+
+		const item_index_t& get_item_index () const {
+			if (auto index = item_index.load (std::memory_order_acquire)) return *index;
+
+			auto& index = static_cast<const File&> (*owner).index<item_index_t> (self.data, [this] {
+				item_index_t index;
+				index.reserve (count () / index_stride + 1);
+				intptr_t n = 0;
+				for (auto items = self.enumerate (); !items.empty (); items.next (), ++n) {
+					if (n % index_stride == 0) index.push_back (items.pos);
+				}
+				return index;
+			});
+			item_index.store (&index, std::memory_order_release);
+			return index;
+		}
+
+		/**
+		 Returns the encoded n-th item or false, if n is out of bounds.
+		 */
+		bool item (intptr_t n, binary::view& result) const {
+			if (n < 0 || n >= count ()) return false;
+			auto items = self.enumerate ();
+			if (count () > index_stride) {
+				auto& index = get_item_index ();
+				items.pos = index[n / index_stride];
+				n %= index_stride;
+			}
+			for (; n > 0; --n) items.next ();
+			result = items.read ();
+			return true;
+		}
+
+		var apply (intptr_t n) const {
+			binary::view result = self;
+			if (!item (n, result)) throw operation_not_supported ();
+			return detail::value (owner, result, depth + 1);
+		}
+		var virtual_apply (const var& n) const override {
+			intptr_t index;
+			if (!pure::detail::index_key (n, index)) throw operation_not_supported ();
+			return apply (index);
+		}
+
+		bool lookup (const var& key, var* result) const override {
+			intptr_t n;
+			binary::view found = self;
+			if (!pure::detail::index_key (key, n) || !item (n, found)) return false;
+			if (result) *result = detail::value (owner, found, depth + 1);
+			return true;
+		}
+
+		intptr_t arity () const noexcept override { return 1; }
+		bool Variadic () const noexcept override { return false; }
+
+		struct enumerator : enumerator_base<var> {
+			owner_t owner;
+			binary::view::enumerator items;
+			intptr_t depth;
+
+			enumerator (owner_t owner, binary::view::enumerator items, intptr_t depth) :
+					owner {std::move (owner)}, items {items}, depth {depth} {}
+
+			bool empty () const noexcept { return items.empty (); }
+			void next () { items.next (); }
+
+			var read () const { return detail::value (owner, items.read (), depth + 1); }
+			var move () { return read (); }
+
+			bool has_size () const noexcept { return true; }
+			intptr_t size () const noexcept { return items.size (); }
+		};
+
+		bool Enumerable () const noexcept override { return true; }
+
+		enumerator enumerate () const { return {owner, self.enumerate (), depth}; }
+		generic_enumerator virtual_enumerate () const override { return enumerate (); }
+
+		intptr_t count () const override { return self.count (); }
+		bool Empty () const override { return count () == 0; }
+
+		var first () const { return nth (0); }
+		var virtual_first () const override { return first (); }
+
+		var second () const { return nth (1); }
+		var virtual_second () const override { return second (); }
+
+		var nth (intptr_t n) const { return apply (n); }
+		var virtual_nth (intptr_t n) const override { return nth (n); }
+
+		template<typename Stream>
+		void print_to (Stream& stream) const {
+			pure::detail::print_sequence_to (stream, enumerate ());
+		}
+		void virtual_print_to (var& stream) const override { this->print_to (stream); }
+	};
+
+	/**
+	 Map, whose keys and values are decoded on access. Small maps are searched linearly. Larger ones build an index of
+	 key hashes on first lookup, so later lookups only decode the keys with the same hash. The index is kept by the
+	 file, so repeated accesses to a nested map don't rebuild it.
+	 */
+	struct Map : Interface::Value {
+		using domain_t = Function_t<Any_t, Any_t>;
+		using pair_type = std::pair<var, var>;
+
+		struct index_entry {
+			int64_t hash;
+			const char* key;
+
+			bool operator< (const index_entry& other) const noexcept { return hash < other.hash; }
+		};
+
+		// Keys sorted by their hash.
+		using key_index_t = std::vector<index_entry>;
+		static constexpr intptr_t linear_lookup_limit = 8;
+
+		owner_t owner;
+		binary::view self;
+		// Number of containers around this one, which is limited to binary::max_depth.
+		intptr_t depth;
+		pure::detail::hash_cache cached_hash;
+		mutable std::atomic<const key_index_t*> key_index {nullptr};
+
+		/**
+		 owner has to be the Mapped::File containing value.
+		 */
+		Map (owner_t owner, binary::view value, intptr_t depth) :
+				owner {std::move (owner)}, self {value.data, value.num_bytes ()}, depth {depth} {
+			if (value.tag () != binary::Tag::Map || depth >= binary::max_depth) throw operation_not_supported ();
+		}
+
+		Map (const Map& other) :
+				owner {other.owner}, self {other.self}, depth {other.depth}, cached_hash {other.cached_hash},
+				key_index {other.key_index.load (std::memory_order_acquire)} {}
+
+		int category_id () const noexcept override { return Any_Function.id; }
+
+		Interface::Value* clone () const& override { return new Map {*this}; }
+		intptr_t clone_bytes_needed () const override { return sizeof (Map); }
+		Interface::Value* clone_placement (void* memory, intptr_t num_bytes) const& override {
+			return new (memory) Map {*this};
+		}
+
+		template<typename Eq>
+		bool equal_map (const Eq& eq, const weak<>& other) const {
+			if (pure::category_id (other) != Any_Function.id || !pure::Enumerable (other) ||
+				pure::count (other) != count ()) return false;
+			for (auto enumerator = pure::enumerate (other); !enumerator.empty (); enumerator.next ()) {
+				auto&& element = enumerator.read ();
+				binary::view found = self;
+				if (!find (pure::first (element), found) ||
+					!eq (detail::value (owner, found, depth + 1), pure::second (element))) return false;
+			}
+			return true;
+		}
+
+		bool equal (const weak<>& other) const override { return equal_map (pure::equal, other); }
+		bool equivalent (const weak<>& other) const override { return equal_map (pure::equivalent, other); }
+
+		int64_t hash () const override {
+			return cached_hash.get ([this] { return pure::detail::hash_map (enumerate ()); });
+		}
+
+		const key_index_t& get_key_index () const {
+			if (auto index = key_index.load (std::memory_order_acquire)) return *index;
+
+			auto& index = static_cast<const File&> (*owner).index<key_index_t> (self.data, [this] {
+				key_index_t index;
+				index.reserve (count ());
+				for (auto items = self.enumerate (); !items.empty (); items.next (), items.next ()) {
+					index.push_back ({detail::key_hash (items.read ()), items.pos});
+				}
+				std::sort (index.begin (), index.end ());
+				return index;
+			});
+			key_index.store (&index, std::memory_order_release);
+			return index;
+		}
+
+		/**
+		 Stores the encoded value for key in result and returns true, if key is in the map.
+		 */
+		bool find (const var& key, binary::view& result) const {
+			if (count () <= linear_lookup_limit) return self.lookup (key, &result);
+
+			auto& index = get_key_index ();
+			auto body_end = self.data + self.num_bytes ();
+			auto range = std::equal_range (index.begin (), index.end (), index_entry {pure::hash (key), nullptr});
+			for (auto entry = range.first; entry != range.second; ++entry) {
+				binary::view candidate {entry->key, body_end - entry->key};
+				if (candidate.equals (key)) {
+					result = {entry->key + candidate.num_bytes (), body_end - entry->key - candidate.num_bytes ()};
+					return true;
+				}
+			}
+			return false;
+		}
+
+		var apply (const var& key) const {
+			binary::view result = self;
+			if (!find (key, result)) throw operation_not_supported ();
+			return detail::value (owner, result, depth + 1);
+		}
+		var virtual_apply (const var& key) const override { return apply (key); }
+
+		bool lookup (const var& key, var* result) const override {
+			binary::view found = self;
+			if (!find (key, found)) return false;
+			if (result) *result = detail::value (owner, found, depth + 1);
+			return true;
+		}
+
+		intptr_t arity () const noexcept override { return 1; }
+		bool Variadic () const noexcept override { return false; }
+
+		struct enumerator : enumerator_base<pair_type> {
+			owner_t owner;
+			binary::view::enumerator items;
+			intptr_t depth;
+
+			enumerator (owner_t owner, binary::view::enumerator items, intptr_t depth) :
+					owner {std::move (owner)}, items {items}, depth {depth} {}
+
+			bool empty () const noexcept { return items.empty (); }
+			void next () {
+				items.next ();
+				items.next ();
+			}
+
+			pair_type read () const {
+				auto values = items;
+				values.next ();
+				return {detail::value (owner, items.read (), depth + 1),
+						detail::value (owner, values.read (), depth + 1)};
+			}
+			pair_type move () { return read (); }
+
+			bool has_size () const noexcept { return true; }
+			intptr_t size () const noexcept { return items.size () / 2; }
+		};
+
+		bool Enumerable () const noexcept override { return true; }
+
+		enumerator enumerate () const { return {owner, self.enumerate (), depth}; }
+		generic_enumerator virtual_enumerate () const override { return enumerate (); }
+
+		intptr_t count () const override { return self.count (); }
+		bool Empty () const override { return count () == 0; }
+
+		template<typename Stream>
+		void print_to (Stream& stream) const {
+			pure::detail::print_map_to (stream, enumerate ());
+		}
+		void virtual_print_to (var& stream) const override { this->print_to (stream); }
+	};
+
+	namespace detail {
+		inline var value (const owner_t& owner, binary::view self, intptr_t depth) {
+			switch (self.tag ()) {
+				case binary::Tag::String : {
+					intptr_t length;
+					auto str = self.get_string (length);
+					if (length < 8 && !std::memchr (str, 0, length)) {
+						char buffer[8] = {};
+						std::memcpy (buffer, str, length);
+						return static_cast<const char*> (buffer);
+					}
+					return immediate<Basic::String_View> {owner, str, length, false};
+				}
+				case binary::Tag::Vector : return immediate<Vector> {owner, self, depth};
+				case binary::Tag::Map : return immediate<Map> {owner, self, depth};
+				default : return self.decode ();
+			}
+		}
+	}
+}
+
+namespace pure::IO {
+	/**
+	 Writes self as a snapshot, which can be opened with open_snapshot.
+	 @return true on success, false if writing to the stream failed
+	 */
+	template<typename Stream, typename T>
+	bool write_snapshot (Stream&& stream, const T& self) {
+		if (!IO::write_raw_bytes (stream, reinterpret_cast<const uint8_t*> (Mapped::snapshot_magic),
+								  sizeof (Mapped::snapshot_magic))) return false;
+		return write_binary (stream, self);
+	}
+
+	/**
+	 Maps the snapshot file at path and returns its root value without decoding it. Vectors and maps inside the
+	 snapshot are returned as Mapped::Vector and Mapped::Map. The file must not be modified while values from it are
+	 alive. Throws operation_not_supported, if the file can't be mapped or isn't a snapshot. Malformed parts of the
+	 value only throw once they are accessed.
+	 */
+	inline var open_snapshot (const char* path) {
+		Mapped::owner_t owner {static_cast<Interface::Value*> (new Mapped::File {path})};
+		auto& file = static_cast<const Mapped::File&> (*owner);
+		auto header = intptr_t (sizeof (Mapped::snapshot_magic));
+		if (file.num_bytes < header || std::memcmp (file.data, Mapped::snapshot_magic, header) != 0)
+			throw operation_not_supported ();
+
+		binary::view root {file.data + header, file.num_bytes - header};
+		if (root.num_bytes () != root.end - root.data) throw operation_not_supported ();
+		return Mapped::detail::value (owner, root, 0);
+	}
+}
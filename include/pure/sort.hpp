@@ -0,0 +1,275 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/types/var.hpp>
+#include <pure/types/immediate.hpp>
+#include <pure/object/basic_vector.hpp>
+#include <pure/support/utf8.hpp>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pure {
+	namespace detail {
+		struct radix_item {
+			uint64_t key;
+			intptr_t index;
+		};
+
+		/**
+		 Stable LSD radix sort on 64 bit keys with 8 bit digits. Digits, which are the same for all items, are skipped,
+		 so e.g. small integers only take one or two passes.
+		 */
+		inline void radix_sort (radix_item* begin, radix_item* end) {
+			if (begin == end) return;
+			intptr_t counts[8][256] = {};
+			for (auto item = begin; item != end; ++item) {
+				for (int digit = 0; digit < 8; ++digit) ++counts[digit][(item->key >> (8 * digit)) & 0xFF];
+			}
+
+			auto num_items = end - begin;
+			std::vector<radix_item> buffer (num_items);
+			radix_item* from = begin;
+			radix_item* to = buffer.data ();
+			for (int digit = 0; digit < 8; ++digit) {
+				auto& count = counts[digit];
+				if (count[(begin->key >> (8 * digit)) & 0xFF] == num_items) continue;
+
+				intptr_t offsets[256];
+				intptr_t offset = 0;
+				for (int i = 0; i < 256; ++i) {
+					offsets[i] = offset;
+					offset += count[i];
+				}
+				for (auto item = from; item != from + num_items; ++item) {
+					to[offsets[(item->key >> (8 * digit)) & 0xFF]++] = *item;
+				}
+				std::swap (from, to);
+			}
+			if (from != begin) std::copy (from, from + num_items, begin);
+		}
+
+		// Keys, whose unsigned order is the order of the values.
+		inline uint64_t radix_key (int64_t value) { return static_cast<uint64_t> (value) ^ (uint64_t {1} << 63); }
+
+		inline uint64_t radix_key (double value) {
+			if (value == 0) value = 0.0;
+			uint64_t bits = 0;
+			std::memcpy (&bits, &value, sizeof (bits));
+			return bits >> 63 ? ~bits : bits | (uint64_t {1} << 63);
+		}
+
+		// First 8 bytes of a string in big endian order, padded with zeros.
+		inline uint64_t radix_key (const char* str, intptr_t length) {
+			uint64_t result = 0;
+			for (intptr_t i = 0; i < 8; ++i) {
+				result = (result << 8) | (i < length ? static_cast<uint8_t> (str[i]) : 0);
+			}
+			return result;
+		}
+
+		struct string_item {
+			uint64_t prefix;
+			const char* str;
+			intptr_t length;
+			intptr_t index;
+		};
+
+		enum class sort_keys { generic, ints, doubles, short_strings, strings };
+
+		inline sort_keys classify_sort_keys (const std::vector<var>& keys) {
+			bool ints = true, doubles = true, short_strings = true, strings = true;
+			for (const auto& key : keys) {
+				auto tag = key.tag ();
+				ints &= tag == Var::Tag::Int || tag == Var::Tag::Int64;
+				doubles &= tag == Var::Tag::Double;
+				short_strings &= tag == Var::Tag::String;
+				strings &= pure::category_id (key) == String.id;
+				if (!(ints || doubles || strings)) return sort_keys::generic;
+			}
+			if (ints) return sort_keys::ints;
+			if (doubles) return sort_keys::doubles;
+			if (short_strings) return sort_keys::short_strings;
+			return strings ? sort_keys::strings : sort_keys::generic;
+		}
+
+		/**
+		 Runs fn (i) for every i in [0, n) on its own thread and rethrows the first exception thrown by any of them.
+		 */
+		template<typename Fn>
+		void run_parallel (intptr_t n, Fn&& fn) {
+			std::vector<std::thread> threads;
+			std::mutex error_mutex;
+			std::exception_ptr error;
+			for (intptr_t i = 0; i < n; ++i) {
+				threads.emplace_back ([&, i] {
+					try { fn (i); }
+					catch (...) {
+						std::lock_guard<std::mutex> lock {error_mutex};
+						if (!error) error = std::current_exception ();
+					}
+				});
+			}
+			for (auto& thread : threads) thread.join ();
+			if (error) std::rethrow_exception (error);
+		}
+
+		/**
+		 Sorts items stably with sort_chunk. With a parallelism above 1, chunks are sorted concurrently and merged
+		 pairwise according to less, also concurrently.
+		 */
+		template<typename Item, typename Sort_Chunk, typename Less>
+		void sort_items (std::vector<Item>& items, intptr_t parallelism, Sort_Chunk&& sort_chunk, Less&& less) {
+			auto size = static_cast<intptr_t> (items.size ());
+			if (parallelism <= 1) {
+				sort_chunk (items.data (), items.data () + size);
+				return;
+			}
+
+			std::vector<intptr_t> bounds;
+			for (intptr_t i = 0; i <= parallelism; ++i) bounds.push_back (size * i / parallelism);
+			run_parallel (parallelism, [&] (intptr_t i) {
+				sort_chunk (items.data () + bounds[i], items.data () + bounds[i + 1]);
+			});
+
+			while (bounds.size () > 2) {
+				auto num_merges = static_cast<intptr_t> (bounds.size () - 1) / 2;
+				run_parallel (num_merges, [&] (intptr_t i) {
+					std::inplace_merge (items.begin () + bounds[2 * i], items.begin () + bounds[2 * i + 1],
+										items.begin () + bounds[2 * i + 2], less);
+				});
+				std::vector<intptr_t> merged;
+				for (size_t i = 0; i < bounds.size (); i += 2) merged.push_back (bounds[i]);
+				if (merged.back () != size) merged.push_back (size);
+				bounds.swap (merged);
+			}
+		}
+
+		/**
+		 Returns the indices of keys in stable order according to pure::compare.
+		 */
+		template<typename T>
+		std::vector<intptr_t> sort_order (const std::vector<T>& keys, intptr_t parallelism) {
+			std::vector<intptr_t> order (keys.size ());
+			for (size_t i = 0; i < keys.size (); ++i) order[i] = i;
+			auto less = [&keys] (intptr_t lhs, intptr_t rhs) { return pure::compare (keys[lhs], keys[rhs]) < 0; };
+			sort_items (order, parallelism, [&less] (intptr_t* begin, intptr_t* end) {
+				std::stable_sort (begin, end, less);
+			}, less);
+			return order;
+		}
+
+		/**
+		 Same as above for keys of type var. If all keys are integers, doubles or short strings, they are radix sorted.
+		 Other strings are sorted by their first 8 bytes and only compared in full on ties.
+		 */
+		inline std::vector<intptr_t> sort_order (const std::vector<var>& keys, intptr_t parallelism) {
+			auto kind = classify_sort_keys (keys);
+			if (kind == sort_keys::generic) return sort_order<var> (keys, parallelism);
+
+			auto size = static_cast<intptr_t> (keys.size ());
+			std::vector<intptr_t> order;
+			order.reserve (size);
+			if (kind == sort_keys::strings) {
+				std::vector<string_item> items;
+				items.reserve (size);
+				for (intptr_t i = 0; i < size; ++i) {
+					auto str = pure::raw_cstring (keys[i]);
+					auto length = pure::raw_cstring_length (keys[i]);
+					items.push_back ({radix_key (str, length), str, length, i});
+				}
+				auto less = [] (const string_item& lhs, const string_item& rhs) {
+					if (lhs.prefix != rhs.prefix) return lhs.prefix < rhs.prefix;
+					return utf8::string_compare (lhs.str, lhs.length, rhs.str, rhs.length) < 0;
+				};
+				sort_items (items, parallelism, [&less] (string_item* begin, string_item* end) {
+					std::stable_sort (begin, end, less);
+				}, less);
+				for (const auto& item : items) order.push_back (item.index);
+				return order;
+			}
+
+			std::vector<radix_item> items;
+			items.reserve (size);
+			for (intptr_t i = 0; i < size; ++i) {
+				const auto& key = keys[i];
+				switch (kind) {
+					case sort_keys::ints : items.push_back ({radix_key (key.get_int64 ()), i}); break;
+					case sort_keys::doubles : items.push_back ({radix_key (key.get_double ()), i}); break;
+					default : {
+						auto str = key.get_cstring ();
+						items.push_back ({radix_key (str, std::strlen (str)), i});
+					}
+				}
+			}
+			sort_items (items, parallelism, radix_sort, [] (const radix_item& lhs, const radix_item& rhs) {
+				return lhs.key < rhs.key;
+			});
+			for (const auto& item : items) order.push_back (item.index);
+			return order;
+		}
+
+		template<typename Seq>
+		auto collect_items (Seq&& seq) {
+			using element_type = std::decay_t<typename decltype (pure::enumerate (seq))::value_type>;
+			std::vector<element_type> items;
+			auto enumerator = pure::enumerate (std::forward<Seq> (seq));
+			if (enumerator.has_size ()) items.reserve (enumerator.size ());
+			for (; !enumerator.empty (); enumerator.next ()) items.emplace_back (enumerator.move ());
+			return items;
+		}
+
+		template<typename T>
+		auto permute (std::vector<T>& items, const std::vector<intptr_t>& order) {
+			std::vector<T> result;
+			result.reserve (items.size ());
+			for (auto index : order) result.emplace_back (std::move (items[index]));
+			return immediate<Basic::Vector<T>> {std::move (result)};
+		}
+
+		// Chunks below this size aren't worth a thread.
+		static constexpr intptr_t min_parallel_sort_chunk = 1 << 14;
+	}
+
+	/**
+	 Returns the items of seq as a Basic::Vector in ascending order according to pure::compare. The sort is stable.
+	 Items, which are all integers, all doubles or all short strings, are radix sorted.
+	 @param seq :: Enumerable
+	 */
+	template<typename Seq>
+	auto sort (Seq&& seq) {
+		auto items = detail::collect_items (std::forward<Seq> (seq));
+		return detail::permute (items, detail::sort_order (items, 1));
+	}
+
+	/**
+	 Returns the items of seq as a Basic::Vector ordered by key_fn (item). key_fn is called exactly once per item and
+	 the sort is stable.
+	 @param key_fn A function of arity 1
+	 @param seq :: Enumerable
+	 */
+	template<typename F, typename Seq>
+	auto sort_by (F&& key_fn, Seq&& seq) {
+		auto items = detail::collect_items (std::forward<Seq> (seq));
+		std::vector<var> keys;
+		keys.reserve (items.size ());
+		for (const auto& item : items) keys.emplace_back (key_fn (item));
+		return detail::permute (items, detail::sort_order (keys, 1));
+	}
+
+	/**
+	 Same as sort, but sorts chunks of seq on parallelism threads and merges them concurrently. Returns the same
+	 result as sort. Small inputs are sorted on the calling thread.
+	 @param seq :: Enumerable
+	 @param parallelism Number of threads, defaults to the number of hardware threads
+	 */
+	template<typename Seq>
+	auto parallel_sort (Seq&& seq, intptr_t parallelism = std::thread::hardware_concurrency ()) {
+		auto items = detail::collect_items (std::forward<Seq> (seq));
+		auto max_parallelism = static_cast<intptr_t> (items.size ()) / detail::min_parallel_sort_chunk;
+		return detail::permute (items, detail::sort_order (items, std::min (parallelism, max_parallelism)));
+	}
+}
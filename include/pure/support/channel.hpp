@@ -0,0 +1,84 @@
+#pragma once
+
+#include <pure/exceptions.hpp>
+#include <pure/types/var.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace pure {
+	/**
+	 Bounded multi-producer multi-consumer queue of values. push blocks while the channel is full and pop blocks while
+	 it is empty, which limits the memory used by a pipeline to the capacity of its channels.
+
+	 Every writer calls close () once it is done. When the last writer has closed the channel, pop returns false as
+	 soon as the remaining items have been drained. abort () closes the channel immediately for readers and writers.
+	 */
+	struct channel {
+		channel (intptr_t capacity, intptr_t num_writers = 1) : capacity {capacity}, num_writers {num_writers} {
+			if (capacity <= 0) throw operation_not_supported ();
+		}
+
+		channel (const channel&) = delete;
+		channel& operator= (const channel&) = delete;
+
+		/**
+		 Blocks until there's space in the channel and appends value. Returns false, if the channel has been aborted.
+		 */
+		bool push (var value) {
+			std::unique_lock<std::mutex> lock {mutex};
+			not_full.wait (lock, [this] { return aborted || intptr_t (items.size ()) < capacity; });
+			if (aborted) return false;
+			items.emplace_back (std::move (value));
+			lock.unlock ();
+			not_empty.notify_one ();
+			return true;
+		}
+
+		/**
+		 Blocks until an item is available and moves it into value. Returns false, if the channel has been aborted or
+		 all writers have closed the channel and no items are left.
+		 */
+		bool pop (var& value) {
+			std::unique_lock<std::mutex> lock {mutex};
+			not_empty.wait (lock, [this] { return aborted || !items.empty () || num_writers == 0; });
+			if (aborted || items.empty ()) return false;
+			value = std::move (items.front ());
+			items.pop_front ();
+			lock.unlock ();
+			not_full.notify_one ();
+			return true;
+		}
+
+		/**
+		 Signals that one of the writers won't push any more items.
+		 */
+		void close () {
+			std::unique_lock<std::mutex> lock {mutex};
+			if (--num_writers > 0) return;
+			lock.unlock ();
+			not_empty.notify_all ();
+		}
+
+		/**
+		 Wakes up all blocked readers and writers and makes every further push and pop fail.
+		 */
+		void abort () {
+			{
+				std::lock_guard<std::mutex> lock {mutex};
+				aborted = true;
+			}
+			not_empty.notify_all ();
+			not_full.notify_all ();
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable not_empty;
+		std::condition_variable not_full;
+		std::deque<var> items;
+		intptr_t capacity;
+		intptr_t num_writers;
+		bool aborted = false;
+	};
+}
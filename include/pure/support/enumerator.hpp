@@ -108,6 +108,8 @@ namespace pure {
 			std::move (other.get ()).move_construct (this, sizeof (*this));
 		}
 
+		~generic_enumerator () { get ().~Enumerator (); }
+
 		generic_enumerator& operator= (generic_enumerator& other) = delete;
 
 		const Interface::Enumerator<var>&
@@ -151,7 +153,7 @@ namespace pure {
 
 		bool empty () const noexcept { return begin == end; }
 		void next () { ++begin; }
-		const value_type& read () const { return *begin; }
+		decltype (*std::declval<const Iterator&> ()) read () const { return *begin; }
 		value_type move () { return *begin; }
 
 		static constexpr bool has_size () { return detail::iterator_has_size<Iterator, Sentinel>::value; }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <pure/traits.hpp>
+#include <pure/support/enumerator.hpp>
+
+#if defined (__cpp_impl_coroutine) && __has_include (<coroutine>)
+#define PURE_HAS_COROUTINES 1
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace pure {
+	/**
+	 Coroutine based sequence. Every co_yield produces the next item, so values can be streamed lazily from e.g. a
+	 file or database cursor into map, filter or reduce without materializing a vector first.
+
+	 A generator is single pass: all enumerators of one generator share the same coroutine and therefore the same
+	 position. Requires C++ 20 coroutine support.
+	 @tparam T Type of the yielded items
+	 */
+	template<typename T>
+	struct generator : implements<Type_Class::Sequence> {
+		struct promise_type {
+			const T* current = nullptr;
+			bool started = false;
+			std::exception_ptr exception;
+
+			generator get_return_object () noexcept {
+				return generator {std::coroutine_handle<promise_type>::from_promise (*this)};
+			}
+
+			std::suspend_always initial_suspend () const noexcept { return {}; }
+			std::suspend_always final_suspend () const noexcept { return {}; }
+
+			// The yielded object lives in the coroutine frame until the coroutine is resumed again.
+			std::suspend_always yield_value (const T& value) noexcept {
+				current = std::addressof (value);
+				return {};
+			}
+
+			void return_void () const noexcept {}
+			void unhandled_exception () noexcept { exception = std::current_exception (); }
+
+			// Resumes the coroutine until the next co_yield and rethrows exceptions escaping the coroutine body.
+			void advance (std::coroutine_handle<promise_type> handle) {
+				started = true;
+				current = nullptr;
+				handle.resume ();
+				if (exception) std::rethrow_exception (std::exchange (exception, nullptr));
+			}
+		};
+
+		using handle_type = std::coroutine_handle<promise_type>;
+		handle_type handle;
+
+		explicit generator (handle_type handle) noexcept : handle {handle} {}
+		generator (generator&& other) noexcept : handle {std::exchange (other.handle, nullptr)} {}
+		generator& operator= (generator&& other) noexcept {
+			std::swap (handle, other.handle);
+			return *this;
+		}
+		~generator () { if (handle) handle.destroy (); }
+
+		/**
+		 Non-owning view of the coroutine. Holds a single handle, so it fits into the inline buffer of
+		 generic_enumerator.
+		 */
+		struct enumerator : enumerator_base<T> {
+			handle_type handle;
+
+			enumerator (const generator& owner) : handle {owner.handle} {
+				if (handle && !handle.promise ().started) handle.promise ().advance (handle);
+			}
+
+			void next () { handle.promise ().advance (handle); }
+			bool empty () const noexcept { return !handle || handle.done (); }
+			const T& read () const noexcept { return *handle.promise ().current; }
+			T move () const { return read (); }
+		};
+
+		enumerator enumerate () const { return {*this}; }
+	};
+}
+
+#endif
@@ -1,95 +1,258 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <random>
 
-namespace pure::detail::murmur3 {
-	constexpr uint32_t c1 = 0xcc9e2d51;
-	constexpr uint32_t c2 = 0x1b873593;
+/**
+ 64 bit hash functions based on wyhash (https://github.com/wangyi-fudan/wyhash, public domain). Strings are hashed
+ 48 bytes per round in three independent lanes. All functions can be evaluated at compile time.
+ */
+namespace pure::detail::wyhash {
+	constexpr uint64_t secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+									0x589965cc75374cc3ull};
 
-	inline uint32_t rotl (uint32_t x, int8_t r) {
-		return (x << r) | (x >> (32 - r));
+	/**
+	 Seed used for hashing strings.
+	 */
+	constexpr uint64_t string_seed = 0xCE7E9683;
+
+	/**
+	 Seed used for hashing characters, so that a character and its code point as an integer hash differently.
+	 */
+	constexpr uint64_t char_seed = 0x3A6F10C7;
+
+	// Full 64 x 64 -> 128 bit multiplication. Returns the low half and stores the high half in high.
+	constexpr uint64_t multiply (uint64_t a, uint64_t b, uint64_t& high) {
+		#if defined (__SIZEOF_INT128__)
+			__uint128_t r = static_cast<__uint128_t> (a) * b;
+			high = static_cast<uint64_t> (r >> 64);
+			return static_cast<uint64_t> (r);
+		#else
+			uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t> (a), lb = static_cast<uint32_t> (b);
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+			uint64_t t = rl + (rm0 << 32);
+			uint64_t carry = t < rl;
+			uint64_t low = t + (rm1 << 32);
+			carry += low < t;
+			high = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+			return low;
+		#endif
 	}
 
-	inline uint32_t mix_k1 (uint32_t k1) {
-		k1 *= c1;
-		k1 = rotl (k1, 15);
-		return k1 * c2;
+	constexpr uint64_t mix (uint64_t a, uint64_t b) {
+		uint64_t high = 0;
+		uint64_t low = multiply (a, b, high);
+		return low ^ high;
 	}
 
-	inline uint32_t mix_h1 (uint32_t h1, uint32_t k1) {
-		h1 ^= k1;
-		h1 = rotl (h1, 13);
-		return h1 * 5 + 0xE6546B64;
+	// Little endian reads byte by byte, which are valid in constant expressions and for unaligned data. Compilers
+	// turn them into single loads.
+	constexpr uint64_t read_4 (const char* p) {
+		return static_cast<uint64_t> (static_cast<uint8_t> (p[0])) |
+			   static_cast<uint64_t> (static_cast<uint8_t> (p[1])) << 8 |
+			   static_cast<uint64_t> (static_cast<uint8_t> (p[2])) << 16 |
+			   static_cast<uint64_t> (static_cast<uint8_t> (p[3])) << 24;
 	}
 
-	inline uint32_t fmix (uint32_t h) {
-		h ^= h >> 16;
-		h *= 0x85ebca6b;
-		h ^= h >> 13;
-		h *= 0xc2b2ae35;
-		h ^= h >> 16;
+	constexpr uint64_t read_8 (const char* p) {
+		return read_4 (p) | read_4 (p + 4) << 32;
+	}
 
-		return h;
+	constexpr uint64_t read_3 (const char* p, intptr_t k) {
+		return (static_cast<uint64_t> (static_cast<uint8_t> (p[0])) << 16) |
+			   (static_cast<uint64_t> (static_cast<uint8_t> (p[k >> 1])) << 8) |
+			   static_cast<uint64_t> (static_cast<uint8_t> (p[k - 1]));
 	}
 
-	inline int32_t hash_raw_bytes (const void* key, int len, uint32_t seed) {
-		auto data = reinterpret_cast<const uint8_t*>(key);
-		const int num_blocks = len / 4;
+	/**
+	 Seed used for hashing sequences, tuples and pairs.
+	 */
+	constexpr uint64_t sequence_seed = 0x1;
 
-		uint32_t h1 = seed;
+	constexpr uint64_t initial_state (uint64_t seed) { return seed ^ mix (seed ^ secret[0], secret[1]); }
 
-		auto blocks = reinterpret_cast<const uint32_t*>(data + num_blocks * 4);
+	/**
+	 Absorbs one 48 byte block into the three lanes of the state.
+	 */
+	constexpr void absorb (const char* p, uint64_t& seed, uint64_t& see1, uint64_t& see2) {
+		seed = mix (read_8 (p) ^ secret[1], read_8 (p + 8) ^ seed);
+		see1 = mix (read_8 (p + 16) ^ secret[2], read_8 (p + 24) ^ see1);
+		see2 = mix (read_8 (p + 32) ^ secret[3], read_8 (p + 40) ^ see2);
+	}
 
-		for (int i = -num_blocks; i; ++i) {
-			uint32_t k1 = mix_k1 (blocks[i]);
-			h1 = mix_h1 (h1, k1);
+	/**
+	 Hashes the last i bytes of an input of len bytes, given the state after absorbing all preceding blocks. If blocks
+	 were absorbed, the 16 bytes before p have to be readable as well.
+	 */
+	constexpr int64_t finish (const char* p, intptr_t i, intptr_t len, uint64_t seed) {
+		uint64_t a = 0, b = 0;
+		if (len <= 16) {
+			if (len >= 4) {
+				a = (read_4 (p) << 32) | read_4 (p + ((len >> 3) << 2));
+				b = (read_4 (p + len - 4) << 32) | read_4 (p + len - 4 - ((len >> 3) << 2));
+			}
+			else if (len > 0) {
+				a = read_3 (p, len);
+			}
+		}
+		else {
+			while (i > 16) {
+				seed = mix (read_8 (p) ^ secret[1], read_8 (p + 8) ^ seed);
+				i -= 16;
+				p += 16;
+			}
+			a = read_8 (p + i - 16);
+			b = read_8 (p + i - 8);
 		}
+		a ^= secret[1];
+		b ^= seed;
+		a = multiply (a, b, b);
+		return static_cast<int64_t> (mix (a ^ secret[0] ^ static_cast<uint64_t> (len), b ^ secret[1]));
+	}
 
-		auto tail = reinterpret_cast<const uint8_t*>(data + num_blocks * 4);
+	/**
+	 Hash of len bytes starting at data.
+	 */
+	constexpr int64_t hash_raw_bytes (const char* p, intptr_t len, uint64_t seed) {
+		seed = initial_state (seed);
+		intptr_t i = len;
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				absorb (p, seed, see1, see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		return finish (p, i, len, seed);
+	}
 
-		uint32_t k1 = 0;
+	inline int64_t hash_raw_bytes (const void* key, intptr_t len, uint64_t seed) {
+		return hash_raw_bytes (reinterpret_cast<const char*> (key), len, seed);
+	}
 
-		switch (len & 3) {
-			case 3: k1 ^= tail[2] << 16;
-			case 2: k1 ^= tail[1] << 8;
-			case 1: k1 ^= tail[0];
-				k1 *= c1;
-				k1 = rotl (k1, 15);
-				k1 *= c2;
-				h1 ^= k1;
-		};
+	inline int64_t hash_cstring (const char* str, uint64_t seed) {
+		return hash_raw_bytes (str, std::strlen (str), seed);
+	}
 
-		h1 ^= len;
-		return fmix (h1);
+	constexpr int64_t hash_int64 (int64_t value, uint64_t seed) {
+		uint64_t a = static_cast<uint64_t> (value) ^ secret[0];
+		uint64_t b = seed ^ secret[1];
+		a = multiply (a, b, b);
+		return static_cast<int64_t> (mix (a ^ secret[0], b ^ secret[1]));
 	}
 
-	inline int32_t hash_cstring (const char* str, uint32_t seed) {
-		return hash_raw_bytes (str, std::strlen (str), seed);
+	/**
+	 Finalizer, which spreads the entropy of all bits of h over the whole result.
+	 */
+	constexpr int64_t fmix (uint64_t h) {
+		return static_cast<int64_t> (mix (h ^ secret[0], secret[2]));
 	}
 
-	inline int32_t hash_int32 (int32_t value, uint32_t seed) {
-		auto h1 = mix_h1 (seed, mix_k1 (value));
-		return fmix (mix_h1 (h1, 0));
+	/**
+	 Combines the hashes of consecutive elements. The result depends on the order of the elements.
+	 */
+	constexpr int64_t hash_combine_ordered (uint64_t a, uint64_t b) {
+		return static_cast<int64_t> (mix (a ^ secret[1], b ^ secret[3]));
 	}
 
-	inline int32_t hash_int64 (int64_t value, uint32_t seed) {
-		uint32_t low = static_cast<uint32_t> (value);
-		uint32_t high = static_cast<uint32_t> (value >> 32);
+	/**
+	 Combines the hashes of elements of a set. Commutative and associative, so the result is independent of the
+	 iteration order.
+	 */
+	constexpr int64_t hash_combine_unordered (uint64_t a, uint64_t b) {
+		return static_cast<int64_t> (a + static_cast<uint64_t> (fmix (b)));
+	}
+}
+
+/**
+ Keyed 64 bit hash functions based on SipHash-1-3 (https://github.com/veorq/SipHash, public domain). Slower than
+ wyhash, but without knowledge of the key an attacker can't produce colliding inputs.
+ */
+namespace pure::detail::siphash {
+	struct key {
+		uint64_t k0;
+		uint64_t k1;
+	};
+
+	constexpr uint64_t rotl (uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+	struct state {
+		uint64_t v0, v1, v2, v3;
+
+		constexpr state (const key& k) : v0 {k.k0 ^ 0x736f6d6570736575ull}, v1 {k.k1 ^ 0x646f72616e646f6dull},
+										 v2 {k.k0 ^ 0x6c7967656e657261ull}, v3 {k.k1 ^ 0x7465646279746573ull} {}
+
+		constexpr void round () {
+			v0 += v1;
+			v1 = rotl (v1, 13);
+			v1 ^= v0;
+			v0 = rotl (v0, 32);
+			v2 += v3;
+			v3 = rotl (v3, 16);
+			v3 ^= v2;
+			v0 += v3;
+			v3 = rotl (v3, 21);
+			v3 ^= v0;
+			v2 += v1;
+			v1 = rotl (v1, 17);
+			v1 ^= v2;
+			v2 = rotl (v2, 32);
+		}
+
+		template<int Rounds>
+		constexpr void compress (uint64_t m) {
+			v3 ^= m;
+			for (int i = 0; i < Rounds; ++i) round ();
+			v0 ^= m;
+		}
+
+		template<int Rounds>
+		constexpr uint64_t finalize () {
+			v2 ^= 0xff;
+			for (int i = 0; i < Rounds; ++i) round ();
+			return v0 ^ v1 ^ v2 ^ v3;
+		}
+	};
 
-		auto h1 = mix_h1 (seed, mix_k1 (low));
-		return fmix (mix_h1 (h1, high));
+	/**
+	 Hash of len bytes starting at p with C compression and D finalization rounds. The default is SipHash-1-3.
+	 */
+	template<int C = 1, int D = 3>
+	constexpr int64_t hash_raw_bytes (const char* p, intptr_t len, const key& k) {
+		state s {k};
+		const char* end = p + (len & ~intptr_t {7});
+		for (; p != end; p += 8) s.compress<C> (wyhash::read_8 (p));
+		uint64_t last = static_cast<uint64_t> (len) << 56;
+		for (int i = 0; i < (len & 7); ++i) last |= static_cast<uint64_t> (static_cast<uint8_t> (p[i])) << (8 * i);
+		s.compress<C> (last);
+		return static_cast<int64_t> (s.finalize<D> ());
 	}
 
-	inline int32_t hash_combine_ordered (uint32_t a, uint32_t b) {
-		return a ^ (b + 0x9E3779B9 + (a << 6) + (a >> 2));
+	template<int C = 1, int D = 3>
+	inline int64_t hash_raw_bytes (const void* data, intptr_t len, const key& k) {
+		return hash_raw_bytes<C, D> (reinterpret_cast<const char*> (data), len, k);
 	}
 
-	inline int32_t hash_combine_unordered (uint32_t a, uint32_t b) {
-		return (a ^ b) + 0x9E3779B9;
+	constexpr int64_t hash_int64 (int64_t value, const key& k) {
+		state s {k};
+		s.compress<1> (static_cast<uint64_t> (value));
+		s.compress<1> (uint64_t {8} << 56);
+		return static_cast<int64_t> (s.finalize<3> ());
 	}
 
-	inline int32_t hash_mix (uint32_t a, uint32_t b) {
-		auto k1 = mix_k1 (a);
-		return fmix (mix_h1 (b, k1));
+	/**
+	 Key drawn from std::random_device on first use, which stays the same for the lifetime of the process.
+	 */
+	inline const key& process_key () {
+		static const key k = [] {
+			std::random_device device;
+			auto draw = [&device] { return static_cast<uint64_t> (device ()) << 32 | device (); };
+			auto k0 = draw ();
+			return key {k0, draw ()};
+		} ();
+		return k;
 	}
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 
 #include <utility>
 #include <pure/support/type_utilities.hpp>
+#include <pure/support/hashing.hpp>
 #include <pure/type_class.hpp>
 
 namespace pure {
@@ -10,6 +11,12 @@ namespace pure {
 		constexpr static_id() = default;
 		static constexpr const char string[sizeof... (Characters)] = {Characters...};
 		static constexpr intptr_t length = sizeof... (Characters) - 1;
+		/**
+		 Hash code of string, computed at compile time. Equal to the hash code of any other string with the same
+		 content. Only pure::hash of the identifier itself returns it. Lookups in maps with var keys convert the
+		 identifier to a string and hash that again.
+		 */
+		static constexpr int64_t hash = detail::wyhash::hash_raw_bytes (string, length, detail::wyhash::string_seed);
 		operator const char* () const noexcept { return string; }
 	};
 
@@ -29,14 +36,38 @@ namespace pure {
 namespace pure {
 	template<typename Char, Char... Chars>
 	constexpr auto operator ""_id () {
+		static_assert (sizeof (Char) == 1, "STR only supports narrow and u8 string literals.");
 		return pure::static_id<static_cast<char>(Chars)..., '\0'> {};
 	}
 }
 
 #define STR(str) static_instance<decltype(str ## _id)>::instance
 #define STR_t(str) decltype (str ## _id)
+#define PURE_HAS_UNLIMITED_STR 1
 
 #pragma GCC diagnostic pop
+#elif defined (__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+// C++ 20 implementation, which passes the literal as a class type template parameter and has no length limit.
+namespace pure::detail {
+	template<typename Char, std::size_t N>
+	struct fixed_string {
+		char characters[N] {};
+		constexpr fixed_string (const Char (& str)[N]) {
+			static_assert (sizeof (Char) == 1, "STR only supports narrow and u8 string literals.");
+			for (std::size_t i = 0; i < N; ++i) characters[i] = static_cast<char> (str[i]);
+		}
+	};
+
+	template<fixed_string str, std::size_t... Indices>
+	constexpr auto static_id_from (std::index_sequence<Indices...>) {
+		return static_id<str.characters[Indices]...> {};
+	}
+}
+
+#define STR_t(str) \
+	decltype (pure::detail::static_id_from<pure::detail::fixed_string {str}> (std::make_index_sequence<sizeof (str) / sizeof (str[0])> {}))
+#define STR(str) static_instance<STR_t (str)>::instance
+#define PURE_HAS_UNLIMITED_STR 1
 #else
 // Macro Implementation
 // All credit goes to https://github.com/taocpp/PEGTL
@@ -86,10 +117,11 @@ namespace pure::detail {
 		using type = static_id<>;
 	};
 
-	template< typename T, std::size_t S >
+	template< typename T, std::size_t S, std::size_t Char_Size >
 	struct string_max_length
 	{
-		static_assert( S <= 64, "String longer than 64 (including terminating \\0)!" );
+		static_assert( Char_Size == 1, "STR only supports narrow and u8 string literals." );
+		static_assert( S <= 64, "String longer than 64 (including terminating \\0)! Compile as C++ 20 to lift the limit." );
 		using type = T;
 	};
 }
@@ -119,7 +151,7 @@ namespace pure::detail {
 #define DETAIL_PURE_CPP_TYPE_STRING(str) \
 	DETAIL_PURE_CPP_EXPAND( \
 		DETAIL_PURE_CPP_EXPAND( \
-			pure::detail::string_max_length<DETAIL_PURE_CPP_STRING_64(str, 0), sizeof (str)>::type))
+			pure::detail::string_max_length<DETAIL_PURE_CPP_STRING_64(str, 0), sizeof (str), sizeof ((str)[0])>::type))
 
 
 #define STR(str) static_instance<DETAIL_PURE_CPP_TYPE_STRING(str)>::instance
@@ -50,8 +50,9 @@ namespace pure {
 			if constexpr (index == T::count) return true;
 			else {
 				if constexpr (pure::Applicable<U, typename record_nth_id<index, typename T::Id_Elements_List>::value>) {
-					if (!eq (apply (other, self.template nth_id<index> ()), self.template nth_element<index> ()))
-						return false;
+					var value;
+					if (!Trait_Functional<U>::lookup (other, self.template nth_id<index> (), &value)) return false;
+					if (!eq (value, self.template nth_element<index> ())) return false;
 					return record_equal_function<index + 1> (eq, self, other);
 				}
 				else return false;
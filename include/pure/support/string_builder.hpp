@@ -2,20 +2,26 @@
 
 #include <pure/object/basic_string.hpp>
 #include <pure/types/unique.hpp>
+#include <pure/types/small.hpp>
+#include <algorithm>
 
 namespace pure::detail {
 
 	struct string_builder : implements<Type_Class::Stream> {
-		unique<Basic::String> result;
+		/**
+		 Strings up to this length are built on the stack and returned without any heap allocation.
+		 */
+		static constexpr intptr_t inline_capacity = 127;
+		using string_type = small<Basic::String, inline_capacity>;
 
-		string_builder (intptr_t capacity = 256) : result {Basic::String::create_empty (capacity)} {}
+		string_type result;
+
+		string_builder (intptr_t capacity = 256) : result {with_capacity, std::max (capacity, inline_capacity), ""} {}
 		//string_builder (const string_builder& other) : result {other.result} {};
 
 		void reserve (intptr_t num_bytes) {
 			if (result->remaining_capacity () >= num_bytes) return;
-			auto new_capacity = result->capacity () * 2;
-			while (new_capacity - result->cstring_length () < num_bytes)
-				new_capacity *= 2;
+			auto new_capacity = result->grown_capacity (result->cstring_length () + num_bytes);
 			result = Basic::String::create_from_cstring (new_capacity, result->cstring (), result->cstring_length ());
 		}
 
@@ -55,7 +61,7 @@ namespace pure::detail {
 					reserve (num_bytes + 32);
 				}
 				else {
-					result->str_end += num_bytes;
+					result->append_written (num_bytes);
 					return true;
 				}
 			}
@@ -63,7 +69,7 @@ namespace pure::detail {
 
 		bool is_exhausted () const noexcept { return false; }
 
-		unique<Basic::String> finish () { return result.release (); }
+		string_type finish () { return std::move (result); }
 	};
 
 }
\ No newline at end of file
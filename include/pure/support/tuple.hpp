@@ -239,7 +239,7 @@ namespace pure {
 				value_type move () const { return generic_nth_get<value_type, 0, count> (self, index); }
 
 				constexpr bool has_size () const noexcept { return true; }
-				constexpr intptr_t size () const noexcept { return count; }
+				constexpr intptr_t size () const noexcept { return count - index; }
 			};
 
 			template<typename T, typename V>
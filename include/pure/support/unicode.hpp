@@ -0,0 +1,210 @@
+#pragma once
+
+#include <pure/support/utf8.hpp>
+#include <pure/support/unicode_tables.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace pure::unicode {
+	/**
+	 Selects one of the case mappings of the Unicode standard. fold maps strings, which only differ in case, to the
+	 same string and is meant for case-insensitive comparison.
+	 */
+	enum class case_mapping { lower, upper, fold };
+
+	namespace detail {
+		template<typename Entry, size_t N>
+		const Entry* find_range (const Entry (& ranges)[N], char32_t c) {
+			auto it = std::upper_bound (ranges, ranges + N, c, [] (char32_t c, const Entry& e) { return c < e.first; });
+			if (it == ranges) return nullptr;
+			--it;
+			return c <= it->last ? it : nullptr;
+		}
+
+		template<size_t N>
+		const tables::special_case* find_special (const tables::special_case (& specials)[N], char32_t c) {
+			auto it = std::lower_bound (specials, specials + N, c, [] (const tables::special_case& e, char32_t c) {
+				return e.code_point < c;
+			});
+			return it != specials + N && it->code_point == c ? it : nullptr;
+		}
+
+		template<size_t N, size_t M>
+		intptr_t map_case (const tables::case_range (& ranges)[N], const tables::special_case (& specials)[M],
+						   char32_t c, char32_t* out) {
+			if (auto special = find_special (specials, c)) {
+				intptr_t n = 0;
+				for (; n < 3 && special->mapping[n]; ++n) out[n] = special->mapping[n];
+				return n;
+			}
+			auto range = find_range (ranges, c);
+			if (range && (c - range->first) % range->stride == 0) out[0] = static_cast<char32_t> (c + range->delta);
+			else out[0] = c;
+			return 1;
+		}
+
+		static inline char map_ascii (char c, case_mapping mapping) {
+			if (mapping == case_mapping::upper) return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+			else return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+		}
+
+		static inline intptr_t map_ascii_prefix_scalar (const char* str, char* out, intptr_t num_bytes,
+														case_mapping mapping) {
+			intptr_t i = 0;
+			for (; i < num_bytes && static_cast<signed char> (str[i]) >= 0; ++i) out[i] = map_ascii (str[i], mapping);
+			return i;
+		}
+
+		#if defined (PURE_UTF8_SSE2)
+		// Flips bit 0x20 of every byte in the letter range, 16 bytes at a time, until a block contains a non-ascii byte.
+		static inline intptr_t map_ascii_prefix_sse2 (const char* str, char* out, intptr_t num_bytes,
+													  case_mapping mapping) {
+			bool upper = mapping == case_mapping::upper;
+			const __m128i below = _mm_set1_epi8 (upper ? 'a' - 1 : 'A' - 1);
+			const __m128i above = _mm_set1_epi8 (upper ? 'z' + 1 : 'Z' + 1);
+			const __m128i flip = _mm_set1_epi8 (0x20);
+			intptr_t i = 0;
+			for (; i + 16 <= num_bytes; i += 16) {
+				__m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (str + i));
+				if (_mm_movemask_epi8 (block)) break;
+				__m128i letters = _mm_and_si128 (_mm_cmpgt_epi8 (block, below), _mm_cmplt_epi8 (block, above));
+				_mm_storeu_si128 (reinterpret_cast<__m128i*> (out + i),
+								  _mm_xor_si128 (block, _mm_and_si128 (letters, flip)));
+			}
+			return i + map_ascii_prefix_scalar (str + i, out + i, num_bytes - i, mapping);
+		}
+		#endif
+
+		static constexpr char32_t hangul_s_base = 0xAC00, hangul_l_base = 0x1100, hangul_v_base = 0x1161,
+				hangul_t_base = 0x11A7;
+		static constexpr char32_t hangul_l_count = 19, hangul_v_count = 21, hangul_t_count = 28;
+		static constexpr char32_t hangul_n_count = hangul_v_count * hangul_t_count;
+		static constexpr char32_t hangul_s_count = hangul_l_count * hangul_n_count;
+
+		static inline void decompose (char32_t c, std::vector<char32_t>& out) {
+			if (c - hangul_s_base < hangul_s_count) {
+				auto index = c - hangul_s_base;
+				out.push_back (hangul_l_base + index / hangul_n_count);
+				out.push_back (hangul_v_base + (index % hangul_n_count) / hangul_t_count);
+				if (index % hangul_t_count) out.push_back (hangul_t_base + index % hangul_t_count);
+				return;
+			}
+			auto end = std::end (tables::decompositions);
+			auto it = std::lower_bound (std::begin (tables::decompositions), end, c,
+										[] (const tables::decomposition& d, char32_t c) { return d.code_point < c; });
+			if (it == end || it->code_point != c) {
+				out.push_back (c);
+				return;
+			}
+			decompose (it->first, out);
+			if (it->second) decompose (it->second, out);
+		}
+
+		static inline char32_t compose (char32_t first, char32_t second) {
+			if (first - hangul_l_base < hangul_l_count && second - hangul_v_base < hangul_v_count) {
+				return hangul_s_base + ((first - hangul_l_base) * hangul_v_count + (second - hangul_v_base)) *
+									   hangul_t_count;
+			}
+			if (first - hangul_s_base < hangul_s_count && (first - hangul_s_base) % hangul_t_count == 0 &&
+				second - hangul_t_base - 1 < hangul_t_count - 1) {
+				return first + (second - hangul_t_base);
+			}
+			auto end = std::end (tables::compositions);
+			auto it = std::lower_bound (std::begin (tables::compositions), end, std::make_pair (first, second),
+										[] (const tables::composition& c, const std::pair<char32_t, char32_t>& key) {
+											return std::make_pair (c.first, c.second) < key;
+										});
+			return it != end && it->first == first && it->second == second ? it->composite : 0;
+		}
+	}
+
+	/**
+	 Writes the case mapping of c to out and returns the number of code points written, which is at most 3. Most
+	 code points map to a single code point, but e.g. the upper case of U+00DF LATIN SMALL LETTER SHARP S is "SS".
+	 */
+	static inline intptr_t map_case (char32_t c, case_mapping mapping, char32_t* out) {
+		switch (mapping) {
+			case case_mapping::lower : return detail::map_case (tables::lower_ranges, tables::lower_specials, c, out);
+			case case_mapping::upper : return detail::map_case (tables::upper_ranges, tables::upper_specials, c, out);
+			default : return detail::map_case (tables::fold_ranges, tables::fold_specials, c, out);
+		}
+	}
+
+	/**
+	 Writes the case mapping of the longest ascii prefix of str to out and returns its length in bytes. Processes 16
+	 bytes per step where SSE2 is available.
+	 */
+	static inline intptr_t map_ascii_prefix (const char* str, char* out, intptr_t num_bytes, case_mapping mapping) {
+		#if defined (PURE_UTF8_SSE2)
+		return detail::map_ascii_prefix_sse2 (str, out, num_bytes, mapping);
+		#else
+		return detail::map_ascii_prefix_scalar (str, out, num_bytes, mapping);
+		#endif
+	}
+
+	/**
+	 Returns the canonical combining class of c. Starters have class 0.
+	 */
+	static inline uint8_t combining_class (char32_t c) {
+		if (c < 0x300) return 0;
+		auto range = detail::find_range (tables::combining_classes, c);
+		return range ? range->combining_class : 0;
+	}
+
+	/**
+	 Returns the number of leading bytes of a utf8 string, which are known to be in NFC without further inspection.
+	 Code points below U+0300 neither compose nor decompose, so the prefix ends before the code point preceding the
+	 first lead byte of a larger code point, which might be the starter of a composition.
+	 */
+	static inline intptr_t nfc_prefix (const char* str, intptr_t num_bytes) {
+		intptr_t i = 0;
+		while (i < num_bytes && static_cast<uint8_t> (str[i]) < 0xCC) ++i;
+		if (i == num_bytes) return i;
+		auto previous = utf8::step_back (str + i, str);
+		return previous ? previous - str : 0;
+	}
+
+	/**
+	 Appends the canonical composition (NFC) of the code points in [begin, end) to out.
+	 */
+	static inline void nfc (const char* begin, const char* end, std::vector<char32_t>& out) {
+		auto start = out.size ();
+		while (begin < end) detail::decompose (utf8::read_char_and_advance (begin), out);
+
+		// Canonical ordering: stable sort every run of non-starters by combining class.
+		for (auto i = start; i < out.size ();) {
+			if (!combining_class (out[i])) {
+				++i;
+				continue;
+			}
+			auto run_end = i;
+			while (run_end < out.size () && combining_class (out[run_end])) ++run_end;
+			std::stable_sort (out.begin () + i, out.begin () + run_end, [] (char32_t a, char32_t b) {
+				return combining_class (a) < combining_class (b);
+			});
+			i = run_end;
+		}
+
+		// Canonical composition of every unblocked character with the last starter. A leading non-starter gets
+		// class 256, so nothing composes with it.
+		if (out.size () == start) return;
+		auto starter = start;
+		auto write = start + 1;
+		int last_class = combining_class (out[start]) ? 256 : 0;
+		for (auto i = start + 1; i < out.size (); ++i) {
+			auto c = out[i];
+			int c_class = combining_class (c);
+			auto composite = detail::compose (out[starter], c);
+			if (composite && (last_class < c_class || last_class == 0)) {
+				out[starter] = composite;
+				continue;
+			}
+			if (c_class == 0) starter = write;
+			last_class = c_class;
+			out[write++] = c;
+		}
+		out.resize (write);
+	}
+}
@@ -2,6 +2,18 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <pure/support/misc.hpp>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PURE_UTF8_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined (PURE_UTF8_SSE2) && defined (PURE_COMPILER_GCC) && (defined (__x86_64__) || defined (__i386__))
+#define PURE_UTF8_AVX2 1
+#include <immintrin.h>
+#endif
 
 namespace pure::utf8 {
 	static inline char32_t read_char (const char* str) {
@@ -19,7 +31,7 @@ namespace pure::utf8 {
 				   (static_cast<uint32_t>(0x3f & static_cast<uint8_t>(str[1])) << 6) |
 				   static_cast<uint32_t>(0x3f & static_cast<uint8_t>(str[2]));
 		}
-		return (static_cast<uint32_t>(n & (0xff >> 4)) << 18) |
+		return (static_cast<uint32_t>(n & (0xff >> 5)) << 18) |
 			   (static_cast<uint32_t>(0x3f & static_cast<uint8_t>(str[1])) << 12) |
 			   (static_cast<uint32_t>(0x3f & static_cast<uint8_t>(str[2])) << 6) |
 			   static_cast<uint32_t>(0x3f & static_cast<uint8_t>(str[3]));
@@ -44,7 +56,7 @@ namespace pure::utf8 {
 		do {
 			if (ptr <= start) return nullptr;
 			--ptr;
-		} while ((*ptr & 0xC) == 0x80);
+		} while ((*ptr & 0xC0) == 0x80);
 		return ptr;
 	}
 
@@ -79,21 +91,172 @@ namespace pure::utf8 {
 				   static_cast<uint32_t>(0x3f & static_cast<uint8_t>(data[2]));
 		}
 		str += 4;
-		return (static_cast<uint32_t>(n & (0xff >> 4)) << 18) |
+		return (static_cast<uint32_t>(n & (0xff >> 5)) << 18) |
 			   (static_cast<uint32_t>(0x3f & static_cast<uint8_t>(data[1])) << 12) |
 			   (static_cast<uint32_t>(0x3f & static_cast<uint8_t>(data[2])) << 6) |
 			   static_cast<uint32_t>(0x3f & static_cast<uint8_t>(data[3]));
 
 	}
 
+	namespace detail {
+		static inline int popcount (uint32_t x) {
+			#if defined (PURE_COMPILER_GCC)
+				return __builtin_popcount (x);
+			#else
+				x = x - ((x >> 1) & 0x55555555);
+				x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+				return static_cast<int> ((((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+			#endif
+		}
+
+		static inline bool is_continuation_byte (char c) { return (static_cast<uint8_t> (c) & 0xC0) == 0x80; }
+
+		static inline intptr_t count_scalar (const char* str, intptr_t num_bytes) {
+			intptr_t count = 0;
+			for (intptr_t i = 0; i < num_bytes; ++i) count += !is_continuation_byte (str[i]);
+			return count;
+		}
+
+		static inline intptr_t ascii_prefix_scalar (const char* str, intptr_t num_bytes) {
+			intptr_t i = 0;
+			while (i < num_bytes && static_cast<signed char> (str[i]) >= 0) ++i;
+			return i;
+		}
+
+		#if defined (PURE_UTF8_SSE2)
+		// Continuation bytes 0x80 - 0xBF are exactly the signed bytes below -64.
+		static inline intptr_t count_sse2 (const char* str, intptr_t num_bytes) {
+			const __m128i threshold = _mm_set1_epi8 (-64);
+			intptr_t count = 0;
+			intptr_t i = 0;
+			for (; i + 16 <= num_bytes; i += 16) {
+				__m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (str + i));
+				auto continuation_mask = static_cast<uint32_t> (_mm_movemask_epi8 (_mm_cmplt_epi8 (block, threshold)));
+				count += 16 - popcount (continuation_mask);
+			}
+			return count + count_scalar (str + i, num_bytes - i);
+		}
+
+		static inline intptr_t ascii_prefix_sse2 (const char* str, intptr_t num_bytes) {
+			intptr_t i = 0;
+			for (; i + 16 <= num_bytes; i += 16) {
+				__m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (str + i));
+				if (_mm_movemask_epi8 (block)) break;
+			}
+			return i + ascii_prefix_scalar (str + i, num_bytes - i);
+		}
+		#endif
+
+		#if defined (PURE_UTF8_AVX2)
+		__attribute__ ((target ("avx2")))
+		static inline intptr_t count_avx2 (const char* str, intptr_t num_bytes) {
+			const __m256i threshold = _mm256_set1_epi8 (-64);
+			intptr_t count = 0;
+			intptr_t i = 0;
+			for (; i + 32 <= num_bytes; i += 32) {
+				__m256i block = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (str + i));
+				auto continuation_mask = static_cast<uint32_t> (_mm256_movemask_epi8 (
+						_mm256_cmpgt_epi8 (threshold, block)));
+				count += 32 - popcount (continuation_mask);
+			}
+			return count + count_sse2 (str + i, num_bytes - i);
+		}
+
+		__attribute__ ((target ("avx2")))
+		static inline intptr_t ascii_prefix_avx2 (const char* str, intptr_t num_bytes) {
+			intptr_t i = 0;
+			for (; i + 32 <= num_bytes; i += 32) {
+				__m256i block = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (str + i));
+				if (_mm256_movemask_epi8 (block)) break;
+			}
+			return i + ascii_prefix_sse2 (str + i, num_bytes - i);
+		}
+		#endif
+
+		struct kernels {
+			intptr_t (* count) (const char*, intptr_t);
+			intptr_t (* ascii_prefix) (const char*, intptr_t);
+		};
+
+		// Picks the widest kernels supported by the cpu. Evaluated once per program.
+		static inline const kernels& select_kernels () {
+			static const kernels selected = [] () -> kernels {
+				#if defined (PURE_UTF8_AVX2)
+				if (__builtin_cpu_supports ("avx2")) return {count_avx2, ascii_prefix_avx2};
+				#endif
+				#if defined (PURE_UTF8_SSE2)
+				return {count_sse2, ascii_prefix_sse2};
+				#else
+				return {count_scalar, ascii_prefix_scalar};
+				#endif
+			} ();
+			return selected;
+		}
+
+		// Validates a single non-ascii sequence starting at str and returns its length or 0 if it is malformed.
+		static inline intptr_t valid_sequence_length (const uint8_t* str, intptr_t num_bytes) {
+			uint8_t lead = str[0];
+			intptr_t length;
+			uint8_t min = 0x80, max = 0xBF;
+			if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+			else if (lead >= 0xE0 && lead <= 0xEF) {
+				length = 3;
+				if (lead == 0xE0) min = 0xA0; // overlong
+				if (lead == 0xED) max = 0x9F; // surrogates
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4) {
+				length = 4;
+				if (lead == 0xF0) min = 0x90; // overlong
+				if (lead == 0xF4) max = 0x8F; // > U+10FFFF
+			}
+			else return 0;
+
+			if (length > num_bytes) return 0;
+			if (str[1] < min || str[1] > max) return 0;
+			for (intptr_t i = 2; i < length; ++i) {
+				if (!is_continuation_byte (static_cast<char> (str[i]))) return 0;
+			}
+			return length;
+		}
+	}
+
+	/**
+	 Returns the number of code points in the first num_bytes bytes of str. Uses SSE2 / AVX2 where available.
+	 */
+	static inline intptr_t count (const char* str, intptr_t num_bytes) {
+		return detail::select_kernels ().count (str, num_bytes);
+	}
+
 	static inline intptr_t count (const char* str) {
-		intptr_t count = 0;
-		while (*str) {
-			str = advance (str);
-			++count;
+		return count (str, static_cast<intptr_t> (std::strlen (str)));
+	}
+
+	/**
+	 Returns true if the first num_bytes bytes of str are all ascii characters.
+	 */
+	static inline bool is_ascii (const char* str, intptr_t num_bytes) {
+		return detail::select_kernels ().ascii_prefix (str, num_bytes) == num_bytes;
+	}
+
+	/**
+	 Returns true if the first num_bytes bytes of str are well-formed utf8, i.e. contain no overlong encodings,
+	 surrogates or code points above U+10FFFF. Ascii runs are skipped with SSE2 / AVX2 where available.
+	 */
+	static inline bool valid (const char* str, intptr_t num_bytes) {
+		auto& kernels = detail::select_kernels ();
+		intptr_t i = 0;
+		while (i < num_bytes) {
+			i += kernels.ascii_prefix (str + i, num_bytes - i);
+			if (i == num_bytes) break;
+			auto length = detail::valid_sequence_length (reinterpret_cast<const uint8_t*> (str + i), num_bytes - i);
+			if (length == 0) return false;
+			i += length;
 		}
+		return true;
+	}
 
-		return count;
+	static inline bool valid (const char* str) {
+		return valid (str, static_cast<intptr_t> (std::strlen (str)));
 	}
 
 	static inline intptr_t bytes_required_for (char32_t character) {
@@ -116,14 +279,14 @@ namespace pure::utf8 {
 			str[1] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 0) & (0xff >> 2)));
 			return str + 2;
 		}
-		else if (c < 0x1000) {
+		else if (c < 0x10000) {
 			str[0] = static_cast<uint8_t> (static_cast<uint32_t>(0xff << 5) | (c >> 12));
 			str[1] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 6) & (0xff >> 2)));
 			str[2] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 0) & (0xff >> 2)));
 			return str + 3;
 		}
 		else {
-			str[0] = static_cast<uint8_t> (static_cast<uint32_t>(0xff << 5) | (c >> 18));
+			str[0] = static_cast<uint8_t> (static_cast<uint32_t>(0xff << 4) | (c >> 18));
 			str[1] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 12) & (0xff >> 2)));
 			str[2] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 6) & (0xff >> 2)));
 			str[3] = static_cast<uint8_t> (static_cast<uint32_t>(0x80) | ((c >> 0) & (0xff >> 2)));
@@ -131,19 +294,21 @@ namespace pure::utf8 {
 		}
 	}
 
+	/**
+	 Compares two null-terminated utf8 strings by code point. For well-formed utf8 the byte order equals the code
+	 point order, so no decoding is necessary and the vectorized strcmp of the C library can be used.
+	 */
 	static int string_compare (const char* lhs, const char* rhs) {
-		for (;;) {
-			auto c1 = read_char_and_advance (lhs);
-			auto c2 = read_char_and_advance (rhs);
-
-			auto diff = static_cast<int32_t>(c1) - static_cast<int32_t>(c2);
-			if (diff) return diff < 0 ? -1 : 1;
-			else {
-				if (c1 == 0)
-					return c2 == 0 ? 0 : -1;
-				else if (c2 == 0)
-					return 1;
-			}
-		}
+		auto result = std::strcmp (lhs, rhs);
+		return (0 < result) - (result < 0);
+	}
+
+	/**
+	 Compares two utf8 strings of known length by code point. Embedded null bytes are compared like any other byte.
+	 */
+	static int string_compare (const char* lhs, intptr_t lhs_length, const char* rhs, intptr_t rhs_length) {
+		auto result = std::memcmp (lhs, rhs, static_cast<size_t> (lhs_length < rhs_length ? lhs_length : rhs_length));
+		if (result) return result < 0 ? -1 : 1;
+		return (rhs_length < lhs_length) - (lhs_length < rhs_length);
 	}
 }
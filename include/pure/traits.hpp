@@ -410,6 +410,8 @@ namespace pure {
 		static constexpr bool Applicable = false;
 		template <typename... Args>
 		static void apply (Args&&...) {throw operation_not_supported();}
+		template <typename... Args>
+		static bool lookup (Args&&...) {throw operation_not_supported();}
 	};
 
 	template<typename T, typename... Args> constexpr bool Applicable = Trait_Functional<T>::template Applicable<Args...>;
@@ -700,10 +702,10 @@ namespace pure {
 	struct Trait_Hash : Trait_Declaration {};
 
 	/**
-	 Returns a 32bit integer hash of a value, which satisfies
+	 Returns a 64bit integer hash of a value, which satisfies
 	 equal (a, b) => hash(a) == hash(b)
 	 */
-	constexpr auto hash = [] (const auto& self) -> int32_t {
+	constexpr auto hash = [] (const auto& self) -> int64_t {
 		return Trait_Hash<std::decay_t<decltype (self)>>::hash (self);
 	};
 
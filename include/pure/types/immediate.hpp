@@ -7,7 +7,8 @@ namespace pure {
 	/**
 	 Value holder, which allocates a value in place, right next to the pointer itself.
 	 @tparam O Type of the held value. Has to have Interface::Value as a base class.
-	 @tparam Capacity Optional capacity needed for variable sized Value types like Basic::String
+	 @tparam Capacity Optional capacity needed for variable sized Value types like Basic::String. Construction throws,
+	 if the value doesn't fit. See small for a holder, which falls back to the heap instead.
 	 */
 	template<typename O, intptr_t Capacity = 0>
 	struct immediate : some<O, never_nil> {
@@ -23,9 +24,10 @@ namespace pure {
 		template<typename... Args>
 		immediate (Args&& ... args) {
 			if constexpr (object_type::has_dynamic_size || std::is_same_v<Interface::Value, object_type>) {
-				auto b = object_type::capacity_to_num_bytes (object_type::capacity_needed (args...));
-				if (b <= Byte_Capacity) {
-					this->init_ptr (Var::Tag::Moveable, new (memory) object_type {b, std::forward<Args> (args)...});
+				auto capacity = object_type::capacity_needed (args...);
+				if (object_type::capacity_to_num_bytes (capacity) <= Byte_Capacity) {
+					this->init_ptr (Var::Tag::Moveable,
+									new (memory) object_type {capacity, std::forward<Args> (args)...});
 				}
 				else {
 					throw operation_not_supported ();
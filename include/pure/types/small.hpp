@@ -0,0 +1,78 @@
+#pragma once
+
+#include <pure/types/some.hpp>
+#include <pure/types/unique.hpp>
+#include <pure/support/create.hpp>
+
+namespace pure {
+	/**
+	 Value holder, which allocates a value in place like immediate, if it fits into the inline storage, and falls
+	 back to a unique heap allocation otherwise. Unlike immediate, construction never fails because of a lack of
+	 space, while small values don't allocate at all.
+	 @tparam O Type of the held value. Has to have Interface::Value as a base class.
+	 @tparam Capacity Capacity of the inline storage for variable sized Value types like Basic::String
+	 */
+	template<typename O, intptr_t Capacity = 0>
+	struct small : some<O, never_nil> {
+		using object_type = O;
+		using domain_t = typename O::domain_t;
+
+		static constexpr bool definitely_mutable_pointer = true;
+
+		static constexpr intptr_t Byte_Capacity = create_capacity_to_num_bytes<O> (Capacity);
+
+		alignas (O) char memory[Byte_Capacity];
+
+		template<typename... Args>
+		small (Args&& ... args) { init (std::forward<Args> (args)...); }
+
+		/**
+		 Takes over the heap allocated value of other without copying it.
+		 */
+		small (unique<O>&& other) { this->init_ptr (Var::Tag::Unique, other.release ()); }
+
+		small (small& other) : small {static_cast<const small&> (other)} {}
+		small (const small& other) { init (other); }
+		small (small&& other) {
+			if (other.read_tag () == Var::Tag::Unique) this->init_ptr (Var::Tag::Unique, other.release ());
+			else init (static_cast<const small&> (other));
+		}
+
+		~small () {
+			if (this->read_tag () == Var::Tag::Moveable) {
+				reinterpret_cast<object_type*>(memory)->~object_type ();
+				this->init_nil ();
+			}
+		}
+
+		template<typename T>
+		small& operator= (T&& other) {
+			if ((void*) &other == (void*) this) return *this;
+			this->~small ();
+			new (this) small {std::forward<T> (other)};
+			return *this;
+		}
+
+		small& operator= (const small& other) { return (*this = static_cast<const small&&> (other)); }
+
+		/**
+		 Returns true, if the value is stored inline.
+		 */
+		bool is_inline () const noexcept { return this->read_tag () == Var::Tag::Moveable; }
+
+		Var::Tag tag () const noexcept { return this->read_tag (); }
+
+	private:
+		template<typename... Args>
+		void init (Args&& ... args) {
+			auto capacity = create_capacity_needed<object_type> (args...);
+			if (create_capacity_to_num_bytes<object_type> (capacity) <= Byte_Capacity) {
+				this->init_ptr (Var::Tag::Moveable, create_placement<object_type> (memory, capacity,
+																				  std::forward<Args> (args)...));
+			}
+			else {
+				this->init_ptr (Var::Tag::Unique, create<object_type> (std::forward<Args> (args)...));
+			}
+		}
+	};
+}
@@ -251,6 +251,29 @@ namespace pure {
 			default : throw operation_not_supported ();
 		}
 	}
+
+	namespace detail {
+		/**
+		 Stores key in index and returns true, if key is an integer. Other keys aren't in the domain of sequences, so
+		 non-throwing lookups in vectors and strings return false for them.
+		 */
+		template<typename Key>
+		bool index_key (const Key& key, intptr_t& index) noexcept {
+			if constexpr (std::is_base_of_v<var, Key>) {
+				switch (key.tag ()) {
+					case Var::Tag::Int :
+					case Var::Tag::Int64 : index = static_cast<intptr_t> (key.get_int64 ());
+						return true;
+					default : return false;
+				}
+			}
+			else if constexpr (std::is_integral_v<Key> && !std::is_same_v<Key, bool>) {
+				index = static_cast<intptr_t> (key);
+				return true;
+			}
+			else return false;
+		}
+	}
 }
 
 namespace pure {
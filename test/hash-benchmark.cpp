@@ -0,0 +1,104 @@
+#include <pure/core.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace pure;
+
+// Reference implementation of the previous 32 bit hash, murmur3 with 4 bytes per round.
+static uint32_t murmur3 (const char* data, intptr_t len, uint32_t seed) {
+	auto rotl = [] (uint32_t x, int r) { return (x << r) | (x >> (32 - r)); };
+	auto mix_k1 = [&] (uint32_t k1) { return rotl (k1 * 0xcc9e2d51, 15) * 0x1b873593; };
+	uint32_t h1 = seed;
+	intptr_t num_blocks = len / 4;
+	for (intptr_t i = 0; i < num_blocks; ++i) {
+		uint32_t k1;
+		std::memcpy (&k1, data + i * 4, 4);
+		h1 = rotl (h1 ^ mix_k1 (k1), 13) * 5 + 0xE6546B64;
+	}
+	auto tail = reinterpret_cast<const uint8_t*> (data + num_blocks * 4);
+	uint32_t k1 = 0;
+	switch (len & 3) {
+		case 3: k1 ^= tail[2] << 16;
+		case 2: k1 ^= tail[1] << 8;
+		case 1: k1 ^= tail[0];
+			h1 ^= mix_k1 (k1);
+	}
+	h1 ^= static_cast<uint32_t> (len);
+	h1 ^= h1 >> 16;
+	h1 *= 0x85ebca6b;
+	h1 ^= h1 >> 13;
+	h1 *= 0xc2b2ae35;
+	return h1 ^ (h1 >> 16);
+}
+
+template<typename Fn>
+static double gigabytes_per_second (const std::string& data, intptr_t length, Fn&& fn) {
+	intptr_t num_rounds = std::max<intptr_t> (1, (intptr_t (1) << 28) / std::max<intptr_t> (length, 8));
+	uint64_t sink = 0;
+	auto start = std::chrono::steady_clock::now ();
+	for (intptr_t i = 0; i < num_rounds; ++i) sink += fn (data.data () + (i & 7), length);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+	if (sink == 42) std::printf (" ");
+	return double (num_rounds) * double (length) / elapsed.count () / 1e9;
+}
+
+template<typename Hash>
+static double milliseconds (const std::vector<var>& keys, Hash hash) {
+	uint64_t sink = 0;
+	auto start = std::chrono::steady_clock::now ();
+	for (const auto& key : keys) sink += hash (key);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now () - start;
+	if (sink == 42) std::printf (" ");
+	return elapsed.count ();
+}
+
+template<typename T>
+static double collision_rate (const std::vector<T>& hashes) {
+	std::unordered_set<T> distinct (hashes.begin (), hashes.end ());
+	return 1.0 - double (distinct.size ()) / double (hashes.size ());
+}
+
+int main () {
+	std::printf ("throughput in GB/s\n%8s %10s %10s %10s\n", "bytes", "murmur3", "wyhash", "siphash");
+	std::string data (1 << 16, 'x');
+	for (size_t i = 0; i < data.size (); ++i) data[i] = char (i * 7919 % 251);
+	for (intptr_t length : {4, 8, 16, 32, 64, 256, 1024, 16384}) {
+		auto old_speed = gigabytes_per_second (data, length, [] (const char* p, intptr_t n) {
+			return uint64_t (murmur3 (p, n, 0xCE7E9683));
+		});
+		auto new_speed = gigabytes_per_second (data, length, [] (const char* p, intptr_t n) {
+			return uint64_t (detail::hash_cstring_with_length (p, n));
+		});
+		auto keyed_speed = gigabytes_per_second (data, length, [] (const char* p, intptr_t n) {
+			return uint64_t (detail::siphash::hash_raw_bytes (p, n, detail::siphash::process_key ()));
+		});
+		std::printf ("%8ld %10.2f %10.2f %10.2f\n", long (length), old_speed, new_speed, keyed_speed);
+	}
+
+	const intptr_t num_keys = 1000000;
+	std::vector<uint32_t> old_string_hashes, old_double_hashes;
+	std::vector<int64_t> new_string_hashes, new_double_hashes;
+	for (intptr_t i = 0; i < num_keys; ++i) {
+		auto key = "key/" + std::to_string (i);
+		old_string_hashes.push_back (murmur3 (key.data (), key.size (), 0xCE7E9683));
+		new_string_hashes.push_back (hash (key.c_str ()));
+
+		double value = double (i) + 0.5;
+		old_double_hashes.push_back (0);
+		new_double_hashes.push_back (hash (value));
+	}
+
+	std::printf ("\ncollision rate of %ld keys\n%8s %10s %10s\n", long (num_keys), "keys", "murmur3", "wyhash");
+	std::printf ("%8s %10.6f %10.6f\n", "strings", collision_rate (old_string_hashes), collision_rate (new_string_hashes));
+	std::printf ("%8s %10.6f %10.6f\n", "doubles", collision_rate (old_double_hashes), collision_rate (new_double_hashes));
+
+	std::vector<var> keys;
+	for (intptr_t i = 0; i < num_keys; ++i) keys.emplace_back (("key/" + std::to_string (i)).c_str ());
+	std::printf ("\nhashing %ld string keys in ms\n%8s %10s\n", long (num_keys), "hash_t", "keyed");
+	std::printf ("%8.1f %10.1f\n", milliseconds (keys, hash_t {}), milliseconds (keys, keyed_hash_t {}));
+	return 0;
+}
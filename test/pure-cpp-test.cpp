@@ -1,6 +1,7 @@
 #include <pure/core.hpp>
 
 #include "catch/catch.hpp"
+#include <cmath>
 #include <tuple>
 #include <vector>
 #include <unordered_map>
@@ -216,6 +217,39 @@ TEST_CASE ("immediate") {
 	REQUIRE_THROWS (immediate<Basic::String, 0> {"String"});
 }
 
+TEST_CASE ("small") {
+	small<Basic::String, 16> inline_str {"String"};
+	REQUIRE (inline_str.is_inline ());
+	REQUIRE (inline_str == "String");
+	REQUIRE (inline_str->capacity () >= 6);
+
+	small<Basic::String, 0> heap_str {"String"};
+	REQUIRE (!heap_str.is_inline ());
+	REQUIRE (heap_str == "String");
+
+	auto moved = std::move (heap_str);
+	REQUIRE (moved == "String");
+	auto copy = inline_str;
+	REQUIRE (copy.is_inline ());
+	REQUIRE (copy == inline_str);
+
+	copy = Basic::String::create_from_cstring (64, "A much longer string than sixteen bytes");
+	REQUIRE (!copy.is_inline ());
+	REQUIRE (copy == "A much longer string than sixteen bytes");
+
+	var v = std::move (copy);
+	REQUIRE (v == "A much longer string than sixteen bytes");
+	var w = inline_str;
+	REQUIRE (w == "String");
+
+	auto short_str = to_string (VEC (1, 2, 3));
+	REQUIRE (short_str.is_inline ());
+	REQUIRE (short_str == "[1, 2, 3]");
+	auto long_str = to_string (std::vector<int> (100, 1));
+	REQUIRE (!long_str.is_inline ());
+	REQUIRE (count (long_str) == 2 + 100 + 99 * 2);
+}
+
 TEST_CASE ("Persistent::Vector") {
 	SECTION ("Construction") {
 		std::vector<char32_t> y {'H', 'e', 'l', 'l', 'o'};
@@ -232,6 +266,54 @@ TEST_CASE ("Persistent::Vector") {
 	}
 }
 
+TEST_CASE ("Persistent::String") {
+	immediate<Persistent::String> hello {"Hello"};
+	REQUIRE (hello == "Hello");
+	REQUIRE (count (hello) == 5);
+
+	var text = immediate<Persistent::String> {""};
+	for (int i = 0; i < 1000; ++i) text = append (std::move (text), i % 2 ? U'\U000000D8' : 'a');
+	REQUIRE (count (text) == 1000);
+	REQUIRE (nth (text, 998) == 'a');
+	REQUIRE (nth (text, 999) == U'\U000000D8');
+	REQUIRE (raw_cstring_length (text) == 1500);
+
+	auto& rope = obj_cast<const Persistent::String&> (text);
+	REQUIRE (rope.root->height <= 4);
+	REQUIRE (rope.slice (2, 5) == u8"a\U000000D8a");
+	REQUIRE (rope.set_persistent ({}, 500, 'x')->nth (500) == 'x');
+	REQUIRE (rope.set_persistent ({}, 1000, 'x')->nth (1000) == 'x');
+	REQUIRE_THROWS (rope.set_persistent ({}, 1001, 'x'));
+	REQUIRE_THROWS (rope.set_persistent ({}, -1, 'x'));
+	REQUIRE (rope.nth (500) == 'a');
+
+	auto twice = rope.concat (rope);
+	REQUIRE (count (twice) == 2000);
+	REQUIRE (to_string (twice->slice (998, 1002)) == u8"a\U000000D8a\U000000D8");
+	REQUIRE (std::string (twice->cstring ()).size () == 3000);
+	REQUIRE (hash (rope.concat (rope)) == hash (twice->cstring ()));
+
+	intptr_t num_chars = 0;
+	for (auto e = enumerate (twice); !e.empty (); e.next ()) ++num_chars;
+	REQUIRE (num_chars == 2000);
+
+	std::string bulk;
+	for (int i = 0; i < 1000; ++i) bulk += i % 3 ? "a" : u8"\U0001F600";
+	immediate<Persistent::String> large {bulk.c_str ()};
+	REQUIRE (large == bulk.c_str ());
+	REQUIRE (count (large) == 1000);
+	REQUIRE (nth (large, 999) == U'\U0001F600');
+	intptr_t max_leaf = 0;
+	detail::rope::for_each_leaf (large->root.get (), [&] (auto& leaf) {
+		REQUIRE (utf8::valid (leaf.str, leaf.str_end - leaf.str));
+		max_leaf = std::max<intptr_t> (max_leaf, leaf.str_end - leaf.str);
+	});
+	REQUIRE (max_leaf <= detail::rope::max_leaf_bytes);
+	auto appended = hello->append_cstring (bulk.c_str (), bulk.size ());
+	REQUIRE (count (appended) == 1005);
+	REQUIRE (appended->root->height <= 4);
+}
+
 TEST_CASE ("Basic::Vector") {
 	auto x = make_vector<int> (1, 2, 3, 4);
 	REQUIRE (x == VEC (1, 2, 3, 4));
@@ -241,6 +323,23 @@ TEST_CASE ("Basic::Vector") {
 
 	REQUIRE (set (x, 2, "3") == VEC (1, 2, "3", 4));
 	REQUIRE (set (x, 2, -3) == VEC (1, 2, -3, 4));
+
+	REQUIRE (equal (x, make_vector<int> (1, 2, 3, 4)));
+	REQUIRE_FALSE (equal (x, make_vector<int> (1, 2, 3, 5)));
+	REQUIRE_FALSE (equal (x, make_vector<int> (1, 2, 3)));
+	REQUIRE (compare (x, make_vector<int> (1, 2, 4)) == -1);
+	REQUIRE (compare (x, make_vector<int> (1, 2, 3)) == 1);
+	REQUIRE (compare (make_vector<int> (), make_vector<int> ()) == 0);
+	REQUIRE (equal (make_vector<bool> (true, false), make_vector<bool> (true, false)));
+	REQUIRE_FALSE (equal (make_vector<bool> (true, false), make_vector<bool> (true, true)));
+
+	auto vec = [] (auto&& ... args) { return var {Persistent::make_vector (args...)}; };
+	auto nested = vec (vec (1, 2), vec (3));
+	REQUIRE (compare (nested, vec (vec (1, 2), vec (2, 9))) == 1);
+	REQUIRE (compare (nested, vec (vec (1, 2), vec (3))) == 0);
+	REQUIRE (equal (nested, vec (vec (1, 2), vec (3))));
+	REQUIRE (equivalent (nested, vec (vec (1.0, 2), vec (3))));
+	REQUIRE_FALSE (equal (nested, vec (vec (1.0, 2), vec (3))));
 }
 
 TEST_CASE ("Primitive Sets") {
@@ -279,6 +378,89 @@ TEST_CASE ("STR") {
 	REQUIRE (STR ("a") == "a");
 	REQUIRE (var {STR ("a")} == "a");
 	REQUIRE (unique<> {STR ("a")} == "a");
+
+	static_assert (STR_t ("Hello")::hash == detail::wyhash::hash_raw_bytes ("Hello", 5, detail::wyhash::string_seed));
+	REQUIRE (hash (STR ("Hello")) == hash ("Hello"));
+	REQUIRE (hash (var {STR ("Hello")}) == hash (var {"Hello"}));
+	REQUIRE (hash (STR ("Hello World, this is a longer identifier")) ==
+			 hash (some<> {"Hello World, this is a longer identifier"}));
+
+#if defined (PURE_HAS_UNLIMITED_STR)
+	auto& long_id = STR ("An identifier, which is longer than the 64 characters supported by the macro implementation");
+	REQUIRE (long_id.length == 91);
+	REQUIRE (long_id == "An identifier, which is longer than the 64 characters supported by the macro implementation");
+#endif
+	REQUIRE (apply (MAP (STR ("a"), 1, STR ("b"), 2), STR ("b")) == 2);
+}
+
+TEST_CASE ("hash") {
+	REQUIRE (hash (2.0) == hash (2));
+	REQUIRE (hash (-0.0) == hash (0.0));
+	REQUIRE (hash (1.5) != hash (2.5));
+	REQUIRE (hash (0.1) != hash (0.2));
+	REQUIRE (hash (1e300) != hash (-1e300));
+	REQUIRE (hash (std::nan ("1")) == hash (std::nan ("2")));
+	REQUIRE (hash (var {1.25}) == hash (1.25));
+	REQUIRE (hash ('a') != hash (int ('a')));
+	REQUIRE (hash (int64_t {1} << 40) != hash (int64_t {1} << 41));
+	REQUIRE (hash (var {"Hello"}) == hash (some<> {"Hello"}));
+	REQUIRE (hash (MAP ("a", 1, "b", 2, "c", 3)) == hash (MAP ("c", 3, "a", 1, "b", 2)));
+	REQUIRE (hash (VEC (1, 2)) != hash (VEC (2, 1)));
+
+	var v = VEC (1, 2);
+	auto h_v = hash (v);
+	REQUIRE (hash (v) == h_v);
+	REQUIRE (hash (var {v}) == h_v);
+	v = append (std::move (v), 3);
+	REQUIRE (hash (v) == hash (VEC (1, 2, 3)));
+	v = set (std::move (v), 2, 4);
+	REQUIRE (hash (v) == hash (VEC (1, 2, 4)));
+
+	var m = MAP (VEC (1, 2), "a");
+	auto h_m = hash (m);
+	m = set (std::move (m), VEC (3), "b");
+	REQUIRE (hash (m) != h_m);
+	REQUIRE (hash (m) == hash (MAP (VEC (3), "b", VEC (1, 2), "a")));
+
+	std::string stream (300, ' ');
+	for (size_t i = 0; i < stream.size (); ++i) stream[i] = char (1 + i * 31 % 126);
+	for (intptr_t length : {0, 3, 16, 17, 48, 49, 64, 65, 97, 300}) {
+		for (intptr_t step : {1, 7, 48, 64, 300}) {
+			hasher h;
+			for (intptr_t i = 0; i < length; i += step) h.update (stream.data () + i, std::min (step, length - i));
+			REQUIRE (h.finish () == hash (std::string (stream, 0, length).c_str ()));
+		}
+	}
+	REQUIRE (hash (VEC (1, "a")) == hasher {detail::wyhash::sequence_seed}.update (1).update ("a").finish ());
+	REQUIRE (hash (VEC (1, "a")) == hash (tuple<int, const char*> (1, "a")));
+
+	detail::siphash::key reference_key {0x0706050403020100, 0x0F0E0D0C0B0A0908};
+	char bytes[15] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+	REQUIRE (uint64_t (detail::siphash::hash_raw_bytes<2, 4> (bytes, 0, reference_key)) == 0x726FDB47DD0E0E31);
+	REQUIRE (uint64_t (detail::siphash::hash_raw_bytes<2, 4> (bytes, 15, reference_key)) == 0xA129CA6149BE45E5);
+	REQUIRE (detail::siphash::hash_int64 (0x0706050403020100, reference_key) ==
+			 detail::siphash::hash_raw_bytes (bytes, 8, reference_key));
+
+	keyed_hash_t keyed;
+	REQUIRE (keyed ("Hello") == keyed (var {"Hello"}));
+	REQUIRE (keyed ("Hello") == keyed (STR ("Hello")));
+	REQUIRE (keyed ("Hello") != keyed ("hello"));
+	REQUIRE (keyed (2.0) == keyed (2));
+	REQUIRE (keyed (VEC ("a", 1)) == keyed (var {tuple<const char*, int> ("a", 1)}));
+	REQUIRE (keyed (VEC ("a", 1)) != keyed (VEC (1, "a")));
+	REQUIRE (keyed (MAP ("a", 1, "b", VEC ("c"))) == keyed (MAP ("b", VEC ("c"), "a", 1)));
+	REQUIRE (keyed (MAP ("a", 1)) != keyed (MAP (1, "a")));
+	REQUIRE (keyed (make_record (STR ("x"), 1, STR ("y"), "z")) == keyed (MAP ("y", "z", "x", 1)));
+
+	immediate<Persistent::Map<var, var, keyed_hash_t>> keyed_map {init, "a", 1, "b", 2};
+	REQUIRE (keyed_map ("a") == 1);
+	REQUIRE (keyed_map (STR ("b")) == 2);
+	REQUIRE (equal (keyed_map, MAP ("b", 2, "a", 1)));
+
+	std::string text (1000, 'x');
+	auto h = hash (text.c_str ());
+	text[500] = 'y';
+	REQUIRE (hash (text.c_str ()) != h);
 }
 
 TEST_CASE ("to_string") {
@@ -289,6 +471,11 @@ TEST_CASE ("to_string") {
 	REQUIRE (to_string ('x') == "x");
 	REQUIRE (to_string (VEC ('x', "x", STR ("x"))) == "['x', \"x\", \"x\"]");
 	REQUIRE (to_string (tuple<int, int> (1, 2)) == "[1, 2]");
+
+	std::string long_text (200, 'x');
+	unique<Basic::String> spelled_out = to_string (long_text.c_str ());
+	REQUIRE (spelled_out == long_text.c_str ());
+	REQUIRE (unique<Basic::String> {to_string (42)} == "42");
 }
 
 TEST_CASE ("Object Casting") {
@@ -310,11 +497,47 @@ TEST_CASE ("Object Casting") {
 
 TEST_CASE ("utf8") {
 	REQUIRE (utf8::read_char (u8"\U000000D8") == U'\U000000D8');
+	REQUIRE (utf8::read_char (u8"\U0001F600") == U'\U0001F600');
+
+	char buffer[5] = {};
+	utf8::write_char (buffer, U'\U000010A0');
+	REQUIRE (utf8::read_char (buffer) == U'\U000010A0');
+	utf8::write_char (buffer, U'\U0001F600');
+	REQUIRE (std::string (buffer) == u8"\U0001F600");
+
+	std::string text;
+	for (int i = 0; i < 100; ++i) text += u8"a\U000000D8\U000020AC\U0001F600";
+	REQUIRE (utf8::count (text.c_str ()) == 400);
+	REQUIRE (utf8::count (text.c_str () + 1, 39) == 15);
+	REQUIRE (count (STR ("Hell\U000000D8")) == 5);
+
+	REQUIRE (utf8::valid (text.c_str ()));
+	REQUIRE (utf8::valid ("Hello World"));
+	REQUIRE (!utf8::valid ("\xC0\xAF"));         // overlong
+	REQUIRE (!utf8::valid ("\xED\xA0\x80"));     // surrogate
+	REQUIRE (!utf8::valid ("\xF4\x90\x80\x80")); // > U+10FFFF
+	REQUIRE (!utf8::valid ((text + "\xE2\x82").c_str ()));
 }
 
 TEST_CASE ("concat") {
 	REQUIRE (concat ("Hello ", "World") == "Hello World");
 	REQUIRE (concat (VEC (1), VEC (2)) == VEC (1, 2));
+
+	REQUIRE (concat ("ab", STR ("cd")) == "abcd");
+	REQUIRE (concat ("ab", var ("cd"), STR ("ef"), "") == "abcdef");
+	REQUIRE (concat ("ab", VEC ('c')) == "abc");
+
+	REQUIRE (concat (VEC (1, 2), VEC (3, 4)) == VEC (1, 2, 3, 4));
+	REQUIRE (concat (VEC (1), VEC (), VEC (2, 3), VEC ("End")) == VEC (1, 2, 3, "End"));
+	REQUIRE (concat (std::vector<int> {1, 2}, range (3, 5)) == VEC (1, 2, 3, 4));
+	var ints = concat (make_vector<int> (1, 2), VEC (3), std::vector<int> {4});
+	REQUIRE (ints == VEC (1, 2, 3, 4));
+	REQUIRE (dynamic_cast<const Basic::Vector<int>*> (ints.operator-> ()));
+
+	var v = VEC (1, 2);
+	var w = concat (v, VEC (3));
+	REQUIRE (concat (w, w) == VEC (1, 2, 3, 1, 2, 3));
+	REQUIRE (v == VEC (1, 2));
 }
 
 TEST_CASE ("Interface::Exception") {
@@ -388,10 +611,136 @@ TEST_CASE ("Basic::String") {
 	unique<Basic::String> x = "Hello World";
 	auto y = make_unique<Basic::String> (with_capacity, 120, "Hi");
 	REQUIRE (y->capacity () == 120);
+
+	REQUIRE (x->ascii);
+	REQUIRE (x->nth (6) == 'W');
+	REQUIRE_THROWS (x->nth (11));
+
+	std::string text;
+	for (int i = 0; i < 50; ++i) text += u8"a\U000000D8\U000020AC\U0001F600";
+	unique<Basic::String> z = text.c_str ();
+	REQUIRE (!z->ascii);
+	REQUIRE (z->nth (0) == 'a');
+	REQUIRE (z->nth (130) == U'\U000020AC');
+	REQUIRE (z->apply (199) == U'\U0001F600');
+	REQUIRE_THROWS (z->nth (200));
+
+	auto w = z->set_persistent ({}, 130, 'x');
+	REQUIRE (w->nth (130) == 'x');
+	REQUIRE (w->nth (131) == U'\U0001F600');
+	REQUIRE (z->nth (130) == U'\U000020AC');
+	z->set_transient ({}, 129, 'y');
+	REQUIRE (z->nth (129) == 'y');
+	REQUIRE (z->nth (199) == U'\U0001F600');
+
+	unique<Basic::String> built = "";
+	intptr_t num_copies = 0;
+	for (int i = 0; i < 10000; ++i) {
+		if (auto grown = built->append_transient ({}, i % 2 ? U'\U000000D8' : 'a')) {
+			built = std::move (grown);
+			++num_copies;
+		}
+	}
+	REQUIRE (count (built) == 10000);
+	REQUIRE (built->nth (9999) == U'\U000000D8');
+	REQUIRE (num_copies < 16);
+	REQUIRE (count (to_string (std::vector<int> (10000, 1))) == 2 + 10000 + 9999 * 2);
 }
 
 using namespace pure;
 
+TEST_CASE ("Basic::String_View") {
+	var text = "The quick brown fox jumps over the lazy dog";
+	immediate<Basic::String_View> all {text};
+	REQUIRE (all == text);
+	REQUIRE (all->data == all->owner->cstring ());
+
+	auto quick = all->slice (4, 9);
+	REQUIRE (quick == "quick");
+	REQUIRE (quick->data == all->data + 4);
+	REQUIRE (!quick->null_terminated);
+	REQUIRE (count (quick) == 5);
+	REQUIRE (nth (quick, 1) == 'u');
+	REQUIRE (hash (quick) == hash ("quick"));
+	REQUIRE (compare (quick, "quick") == 0);
+	REQUIRE (compare (quick, "quicker") < 0);
+	REQUIRE (to_string (quick) == "quick");
+
+	var held = quick;
+	text = nullptr;
+	REQUIRE (held == "quick");
+	REQUIRE (all->slice (40, 43)->null_terminated);
+
+	const char buffer[] = {'a', 'b', 'c'};
+	immediate<Basic::String_View> unowned {buffer, 2};
+	REQUIRE (unowned == "ab");
+	REQUIRE (std::strlen (unowned->cstring ()) == 2);
+}
+
+TEST_CASE ("String Functions") {
+	var text = u8"Gr\U000000FC\U000000DFe, Welt, und Gr\U000000FC\U000000DFe";
+
+	REQUIRE (subs (text, 0, 6) == u8"Gr\U000000FC\U000000DFe,");
+	REQUIRE (subs (text, 17) == u8"Gr\U000000FC\U000000DFe");
+	REQUIRE (subs (subs (text, 7), 0, 4) == "Welt");
+	REQUIRE (subs (STR ("Hello World"), 6, 11) == "World");
+	REQUIRE_THROWS (subs (text, 3, 100));
+
+	REQUIRE (to_string (split (text, ", ")) == u8"[\"Gr\U000000FC\U000000DFe\", \"Welt\", \"und Gr\U000000FC\U000000DFe\"]");
+	REQUIRE (count (split ("a,,b,", ",")) == 4);
+	REQUIRE (count (split ("", ",")) == 1);
+	REQUIRE_THROWS (split ("abc", ""));
+
+	REQUIRE (join (", ", split (text, ", ")) == text);
+	REQUIRE (join ("-", VEC ("a", STR ("b"), "c")) == "a-b-c");
+	REQUIRE (join ("-", VEC ()) == "");
+	int calls = 0;
+	auto parity = [&calls] (intptr_t x) { ++calls; return x % 2 ? "odd" : "even"; };
+	REQUIRE (join (",", map (parity, range (3))) == "even,odd,even");
+	REQUIRE (calls == 3);
+
+	REQUIRE (index_of (text, "Welt") == 7);
+	REQUIRE (index_of (text, "Mond") == -1);
+	REQUIRE (index_of (text, u8"\U000000DFe, W") == 3);
+	REQUIRE (starts_with (text, u8"Gr\U000000FC"));
+	REQUIRE (!starts_with ("Gr", text));
+
+	REQUIRE (replace (text, u8"Gr\U000000FC\U000000DFe", "Hallo") == "Hallo, Welt, und Hallo");
+	REQUIRE (replace ("aaa", "a", "bb") == "bbbbbb");
+	REQUIRE (replace ("abc", "x", "y") == "abc");
+}
+
+TEST_CASE ("Case Mapping and Normalization") {
+	REQUIRE (lower ("Hello World, this is a Longer ASCII Text") == "hello world, this is a longer ascii text");
+	REQUIRE (upper ("Hello World, this is a Longer ASCII Text") == "HELLO WORLD, THIS IS A LONGER ASCII TEXT");
+	REQUIRE (lower (u8"Stra\U000000DFe \U0000023A \U000001C5emal") == u8"stra\U000000DFe \U00002C65 \U000001C6emal");
+	REQUIRE (upper (u8"Stra\U000000DFe \U00002C65 \U0000FB00") == u8"STRASSE \U0000023A FF");
+	REQUIRE (casefold (u8"Stra\U000000DFe") == "strasse");
+	REQUIRE (lower (u8"\U00000130") == u8"i\U00000307");
+	REQUIRE (lower ("") == "");
+
+	std::string long_text;
+	for (int i = 0; i < 100; ++i) long_text += u8"ABC \U000000C4\U000003A3 xyz ";
+	auto long_lower = lower (long_text.c_str ());
+	REQUIRE (!long_lower.is_inline ());
+	REQUIRE (count (long_lower) == 100 * 11);
+	REQUIRE (starts_with (long_lower, u8"abc \U000000E4\U000003C3 xyz abc"));
+
+	REQUIRE (casefold_equal (u8"Stra\U000000DFe", "STRASSE"));
+	REQUIRE (casefold_equal (var {"Hello"}, "hELLO"));
+	REQUIRE (!casefold_equal ("Hello", "Hell"));
+	REQUIRE (casefold_compare ("apple", "Banana") == -1);
+	REQUIRE (casefold_compare ("Banana", "apple") == 1);
+	REQUIRE (casefold_hash (u8"\U000003A3\U000003B1\U000003C2") == casefold_hash (u8"\U000003C3\U00000391\U000003A3"));
+	REQUIRE (casefold_hash ("Hello") == hash ("hello"));
+
+	REQUIRE (nfc ("Already normalized") == "Already normalized");
+	REQUIRE (nfc (u8"e\U00000323\U00000301 A\U0000030A \U00001100\U00001161\U000011A8 \U0000212B q\U00000307\U00000323") ==
+			 u8"\U00001EB9\U00000301 \U000000C5 \U0000AC01 \U000000C5 q\U00000323\U00000307");
+	REQUIRE (nfc (u8"\U00000301abc") == u8"\U00000301abc");
+	REQUIRE (nfc (u8"\U000000C5") == u8"\U000000C5");
+}
+
 TEST_CASE ("From Var") {
 	bool b = var {true};
 	REQUIRE (b);
@@ -412,6 +761,30 @@ TEST_CASE ("compare") {
 	REQUIRE (var (1) == var {true});
 
 	REQUIRE (equal ("Hello", var {"Hello"}));
+
+	REQUIRE (compare ("abc", "abd") == -1);
+	REQUIRE (compare ("abc", "ab") == 1);
+	REQUIRE (compare ("", "") == 0);
+	REQUIRE (compare (u8"\U000000D8", "z") == 1);
+	REQUIRE (compare (u8"\U0001F600", u8"\U0000FFFD") == 1);
+	REQUIRE (compare (var {"short"}, var {"shorter than seven"}) == -1);
+	REQUIRE (compare (var {u8"long \U000000D8 string"}, var {"long z string"}) == 1);
+	REQUIRE (compare (some<Basic::String> ("Hello World"), "Hello Worlds") == -1);
+	REQUIRE (compare (some<Basic::String> ("Hello World"), some<Basic::String> ("Hello World")) == 0);
+	REQUIRE (compare (immediate<Basic::String_View> {"Hello World", 5}, some<Basic::String> ("Hello World")) == -1);
+	REQUIRE (compare (some<Basic::String> ("Hello"), 5) == compare (String.id, Int.id));
+
+	REQUIRE (equal (MAP ("a", 1, "b", 2), MAP ("b", 2, "a", 1)));
+	REQUIRE_FALSE (equal (MAP ("a", 1), MAP ("b", 1)));
+	REQUIRE_FALSE (equal (MAP ("a", 1), MAP ("a", 2)));
+	REQUIRE_FALSE (equal (MAP ("a", 1), MAP ("a", 1, "b", 2)));
+	REQUIRE (equivalent (MAP ("a", 1), MAP ("a", 1.0)));
+	REQUIRE (equal (MAP ("x", 1), MAP (STR ("x"), 1)));
+	REQUIRE_FALSE (equal (MAP ("x", 1), MAP (STR ("y"), 1)));
+	REQUIRE_FALSE (equal (MAP (STR ("y"), 1), MAP ("x", 1)));
+	immediate<Persistent::Map<var, var, keyed_hash_t>> keyed {init, "a", 1};
+	REQUIRE (equal (keyed, MAP ("a", 1)));
+	REQUIRE_FALSE (equal (keyed, MAP ("b", 1)));
 }
 
 TEST_CASE ("Arithmetic") {
@@ -433,6 +806,51 @@ TEST_CASE ("Functional") {
 
 	unique<> str = "Hello";
 	REQUIRE (set (str, 0, 'h') == "hello");
+	some<> greeting = "Hello";
+	REQUIRE (set (greeting, 5, '!') == "Hello!");
+	REQUIRE_THROWS (set (greeting, 6, '!'));
+	auto hello = to_string ("Hello");
+	REQUIRE (Nil (hello->set_transient ({}, 5, '!')));
+	REQUIRE (hello == "Hello!");
+	REQUIRE_THROWS (hello->set_transient ({}, 7, '!'));
+
+	var map = MAP ("a", 1, "b", "two");
+	REQUIRE (contains (map, "a"));
+	REQUIRE_FALSE (contains (map, "c"));
+	REQUIRE (get (map, "a", 0) == 1);
+	REQUIRE (get (map, "c", 0) == 0);
+	REQUIRE (find (map, "b") == "two");
+	REQUIRE (Nil (find (map, "c")));
+
+	var typed = immediate<Persistent::Map<intptr_t, var>> {init, 1, "one", 2, "two"};
+	REQUIRE (contains (typed, 1));
+	REQUIRE_FALSE (contains (typed, "a"));
+	REQUIRE (get (typed, 2, nullptr) == "two");
+	REQUIRE (get (typed, 1.5, nullptr) == nullptr);
+	REQUIRE (Nil (find (typed, "a")));
+	REQUIRE_FALSE (typed == MAP ("a", 1, "b", 2));
+	REQUIRE (typed == MAP (1, "one", 2, "two"));
+
+	var vec = VEC (1, 2, 3);
+	REQUIRE (contains (vec, 2));
+	REQUIRE_FALSE (contains (vec, 3));
+	REQUIRE_FALSE (contains (vec, -1));
+	REQUIRE_FALSE (contains (vec, "a"));
+	REQUIRE (get (vec, 5, nullptr) == nullptr);
+	REQUIRE (get (std::vector<int> {1, 2}, 1, 0) == 2);
+	REQUIRE (get (std::make_tuple (1, "a"), 2, 0) == 0);
+
+	REQUIRE (get (u8"Hell\U000000D8", 4, 0) == U'\U000000D8');
+	REQUIRE_FALSE (contains (u8"Hell\U000000D8", 5));
+	REQUIRE (get (var ("abc"), 1, 0) == 'b');
+	REQUIRE_FALSE (contains (some<Basic::String> ("Hello World"), 11));
+	REQUIRE (get (some<Basic::String> ("Hello World"), 10, 0) == 'd');
+
+	auto record = make_record (STR ("x"), 1);
+	REQUIRE (get (record, STR ("x"), 0) == 1);
+	REQUIRE_FALSE (contains (record, STR ("y")));
+
+	REQUIRE_THROWS (contains (var (1), 0));
 }
 
 TEST_CASE ("Enumerable") {
@@ -457,6 +875,7 @@ TEST_CASE ("Enumerable") {
 
 TEST_CASE ("fopen") {
 	IO::print_to (IO::fopen ("test.txt", "w"), "Hello World");
+	REQUIRE (std::remove ("test.txt") == 0);
 }
 
 TEST_CASE ("Error") {
@@ -538,6 +957,288 @@ TEST_CASE ("Constructors") {
 	REQUIRE (set (a, 0, 4) (0) == 4);
 }
 
+TEST_CASE ("Lazy Sequences") {
+	REQUIRE (take (2, VEC (1, 2, 3)) == VEC (1, 2));
+	REQUIRE (count (take (5, VEC (1, 2, 3))) == 3);
+	REQUIRE (take (3, range (0, INTPTR_MAX)) == VEC (0, 1, 2));
+	int calls = 0;
+	auto odd = [&calls] (intptr_t x) { ++calls; return x % 2 == 1; };
+	for (auto enumerator = enumerate (take (1, filter (odd, range (0, 1000000)))); !enumerator.empty ();
+		 enumerator.next ()) REQUIRE (enumerator.read () == 1);
+	REQUIRE (calls == 2);
+	REQUIRE (drop (2, VEC (1, 2, 3)) == VEC (3));
+	REQUIRE (count (drop (5, VEC (1, 2, 3))) == 0);
+	REQUIRE (take_while ([] (int x) { return x < 3; }, VEC (1, 2, 3, 1)) == VEC (1, 2));
+
+	REQUIRE (count (range (0, 10, 3)) == 4);
+	REQUIRE (range (5, 0, -2) == VEC (5, 3, 1));
+	REQUIRE (count (range (3)) == 3);
+	REQUIRE (count (range (0, INTPTR_MAX)) == INTPTR_MAX);
+	REQUIRE_THROWS (count (range (-10, INTPTR_MAX)));
+	REQUIRE (count (range (INTPTR_MIN, INTPTR_MAX, INTPTR_MAX)) == 3);
+	REQUIRE (range (INTPTR_MIN, INTPTR_MAX, INTPTR_MAX) == VEC (INTPTR_MIN, -1, INTPTR_MAX - 1));
+	REQUIRE (range (INTPTR_MAX, INTPTR_MIN, INTPTR_MIN) == VEC (INTPTR_MAX, -1));
+	REQUIRE (count (range (INTPTR_MAX, INTPTR_MIN, INTPTR_MIN)) == 2);
+
+	REQUIRE (to_string (chunk (2, VEC (1, 2, 3, 4, 5))) == "[[1, 2], [3, 4], [5]]");
+	REQUIRE (count (chunk (2, VEC (1, 2, 3, 4, 5))) == 3);
+	REQUIRE (to_string (partition_by ([] (int x) { return x % 2 == 0; }, VEC (1, 3, 2, 4, 5))) ==
+			 "[[1, 3], [2, 4], [5]]");
+
+	REQUIRE (interleave (VEC (1, 2, 3), VEC ('a', 'b')) == VEC (1, 'a', 2, 'b'));
+	REQUIRE (count (interleave (range (3), range (2))) == 4);
+
+	var v = map ([] (auto x) { return x * 2; }, take (2, range (10)));
+	REQUIRE (count (v) == 2);
+	REQUIRE (v == VEC (0, 2));
+}
+
+TEST_CASE ("Lazy Seq") {
+	int calls = 0;
+	auto squares = lazy_seq (map ([&calls] (intptr_t x) { ++calls; return x * x; }, range (100)));
+	REQUIRE (count (squares) == 100);
+	REQUIRE (calls == 100);
+	REQUIRE (nth (squares, 99) == 99 * 99);
+	REQUIRE (equal (take (3, squares), VEC (0, 1, 4)));
+	REQUIRE (calls == 100);
+
+	auto copy = squares;
+	REQUIRE (count (copy) == 100);
+	REQUIRE (calls == 100);
+
+	int infinite_calls = 0;
+	auto naturals = lazy_seq (map ([&] (intptr_t x) { ++infinite_calls; return x; }, range (0, INTPTR_MAX)));
+	REQUIRE (take (3, naturals) == VEC (0, 1, 2));
+	REQUIRE (infinite_calls == 32);
+
+	REQUIRE (count (lazy_seq (VEC ())) == 0);
+}
+
+#if defined (PURE_HAS_COROUTINES)
+generator<intptr_t> count_up (intptr_t n) {
+	for (intptr_t i = 0; i < n; ++i) co_yield i;
+}
+
+TEST_CASE ("Generator") {
+	REQUIRE (reduce ([] (intptr_t result, intptr_t next) { return result + next; }, 0, count_up (5)) == 10);
+	REQUIRE (filter ([] (intptr_t x) { return x % 2 == 0; }, count_up (5)) == VEC (0, 2, 4));
+	REQUIRE (take (3, count_up (INTPTR_MAX)) == VEC (0, 1, 2));
+
+	detail::string_builder stream;
+	REQUIRE (IO::write_binary (stream, count_up (3)));
+	auto bytes = stream.finish ();
+	REQUIRE (IO::read_binary (bytes->cstring (), bytes->cstring_length ()) == VEC (0, 1, 2));
+	REQUIRE (join (", ", map ([] (intptr_t x) { return x == 0 ? "zero" : "more"; }, count_up (3))) ==
+			 "zero, more, more");
+
+	auto gen = count_up (3);
+	generic_enumerator boxed {gen.enumerate ()};
+	REQUIRE (boxed.read () == 0);
+	boxed.next ();
+	REQUIRE (boxed.read () == 1);
+}
+#endif
+
+TEST_CASE ("Pipeline") {
+	channel c {2};
+	REQUIRE (c.push (1));
+	REQUIRE (c.push (2));
+	c.close ();
+	var value;
+	REQUIRE (c.pop (value));
+	REQUIRE (value == 1);
+	REQUIRE (c.pop (value));
+	REQUIRE (!c.pop (value));
+
+	intptr_t sum = 0;
+	intptr_t num_items = 0;
+	pipe (range (1000),
+		  [] (const var& x) { return x + 1; },
+		  parallel (4, [] (const var& x) { return x * 2; }),
+		  [&] (const var& x) {
+			  sum += intptr_t (x);
+			  ++num_items;
+		  });
+	REQUIRE (num_items == 1000);
+	REQUIRE (sum == 1001000);
+
+	auto failing = [] (const var& x) -> var {
+		if (x == 500) throw operation_not_supported ();
+		return x;
+	};
+	REQUIRE_THROWS_AS (pipe (range (10000), parallel (2, failing), [] (const var&) {}), operation_not_supported);
+}
+
+TEST_CASE ("sort") {
+	REQUIRE (sort (VEC (3, -1, 2, int64_t {1} << 40, -5)) == VEC (-5, -1, 2, 3, int64_t {1} << 40));
+	REQUIRE (sort (VEC (2.5, -0.5, 1e300, -1e300, 0.0)) == VEC (-1e300, -0.5, 0.0, 2.5, 1e300));
+	REQUIRE (sort (VEC ("b", "ab", "a", "", "ba")) == VEC ("", "a", "ab", "b", "ba"));
+	REQUIRE (sort (VEC (STR ("a long string b"), "a", STR ("a long string a"), u8"\U000000D8")) ==
+			 VEC ("a", "a long string a", "a long string b", u8"\U000000D8"));
+	REQUIRE (sort (VEC (2, 1.5, 'a', "x", 0)) == sort (VEC (0, 'a', 2, "x", 1.5)));
+	REQUIRE (sort (make_vector<int> (3, 1, 2)) == VEC (1, 2, 3));
+	REQUIRE (count (sort (VEC ())) == 0);
+
+	auto negative_zero = sort (VEC (0.0, -0.0, -1.0));
+	REQUIRE (std::signbit (double (nth (negative_zero, 1))) == false);
+	REQUIRE (std::signbit (double (nth (negative_zero, 2))) == true);
+
+	auto by_length = sort_by ([] (const var& s) { return count (s); }, VEC ("ccc", "b", "aa", "a", "bb"));
+	REQUIRE (by_length == VEC ("b", "a", "aa", "bb", "ccc"));
+
+	std::vector<var> numbers;
+	for (intptr_t i = 0; i < 100000; ++i) numbers.emplace_back ((i * 7919) % 100003 - 50000);
+	auto sorted = sort (numbers);
+	REQUIRE (parallel_sort (numbers, 4) == sorted);
+	bool ascending = true;
+	for (intptr_t i = 1; i < count (sorted); ++i) ascending &= nth (sorted, i - 1) <= nth (sorted, i);
+	REQUIRE (ascending);
+
+	std::vector<var> strings;
+	for (intptr_t i = 0; i < 40000; ++i) strings.emplace_back (to_string ((i * 7919) % 40009));
+	REQUIRE (parallel_sort (strings, 3) == sort (strings));
+}
+
+TEST_CASE ("binary") {
+	auto encode = [] (const auto& value) {
+		detail::string_builder stream;
+		REQUIRE (IO::write_binary (stream, value));
+		auto bytes = stream.finish ();
+		return std::string {bytes->cstring (), size_t (bytes->cstring_length ())};
+	};
+	auto decode = [] (const std::string& bytes) { return IO::read_binary (bytes.data (), bytes.size ()); };
+
+	REQUIRE (encode (nullptr) == std::string (1, '\0'));
+	REQUIRE (encode (-1) == "\x03\x01");
+	REQUIRE (encode ("ab") == "\x06\x02" "ab");
+	REQUIRE (encode (VEC (1, 2)) == "\x07\x02\x04\x03\x02\x03\x04");
+
+	var value = MAP ("ints", VEC (0, -1, int64_t {1} << 40, INT64_MIN), "double", 2.5, "char", U'\U0001F600',
+					 "flags", VEC (true, false, nullptr), "a longer string", MAP (1, VEC ()), "seven", 7);
+	auto bytes = encode (value);
+	REQUIRE (decode (bytes) == value);
+	REQUIRE (decode (encode (make_record (STR ("x"), 1, STR ("y"), "z"))) == MAP ("x", 1, "y", "z"));
+	REQUIRE (decode (encode (std::vector<int> {1, 2, 3})) == VEC (1, 2, 3));
+	int calls = 0;
+	auto even = [&calls] (int x) { ++calls; return x % 2 == 0; };
+	REQUIRE (decode (encode (filter (even, VEC (1, 2, 3, 4)))) == VEC (2, 4));
+	REQUIRE (calls == 4);
+
+	REQUIRE (IO::write_binary (IO::fopen ("test.binary", "wb"), value));
+	REQUIRE_FALSE (IO::write_binary (IO::fopen ("test.binary", "rb"), value));
+	REQUIRE (std::remove ("test.binary") == 0);
+
+	binary::view root {bytes.data (), intptr_t (bytes.size ())};
+	REQUIRE (root.tag () == binary::Tag::Map);
+	REQUIRE (root.count () == 6);
+	REQUIRE (root.num_bytes () == intptr_t (bytes.size ()));
+	binary::view ints = root;
+	REQUIRE (root.lookup ("ints", &ints));
+	REQUIRE (ints.nth (3).get_int () == INT64_MIN);
+	binary::view string = root;
+	REQUIRE (root.lookup ("seven", nullptr));
+	REQUIRE_FALSE (root.lookup ("missing", nullptr));
+	REQUIRE (root.lookup ("a longer string", &string));
+	REQUIRE (string.tag () == binary::Tag::Map);
+	REQUIRE (root.lookup ("char", &string));
+	REQUIRE (string.get_char () == U'\U0001F600');
+
+	auto text = encode (STR ("zero copy"));
+	auto view = binary::view {text.data (), intptr_t (text.size ())}.get_string_view ();
+	REQUIRE (view == "zero copy");
+	REQUIRE (view->data == text.data () + 2);
+
+	REQUIRE_THROWS (decode (""));
+	REQUIRE_THROWS (decode ("\x09"));
+	REQUIRE_THROWS (decode ("\x06\x05" "ab"));
+	REQUIRE_THROWS (decode ("\x07\x03\x02\x03\x02"));
+	REQUIRE_THROWS (decode ({"\x07\x01\x04\x06\x03" "ab", 7}));
+	REQUIRE_THROWS (decode ({"\x07\x01\x04\x07\x01\x02\x00", 7}));
+	REQUIRE_THROWS (decode ("\x06\x02\xFF\xFE"));
+	auto duplicate = encode (MAP ("a", 1, "b", 2));
+	for (auto& c : duplicate) if (c == 'b') c = 'a';
+	REQUIRE_THROWS (decode (duplicate));
+	REQUIRE (decode (encode (-0.15625)) == -0.15625);
+	REQUIRE (encode (1.0) == std::string ("\x04\0\0\0\0\0\0\xF0\x3F", 9));
+
+	var deep = nullptr;
+	for (intptr_t i = 0; i < binary::max_depth; ++i) deep = VEC (deep);
+	REQUIRE (decode (encode (deep)) == deep);
+	REQUIRE_THROWS (decode (encode (VEC (deep))));
+	REQUIRE_THROWS (binary::view {"\x06\x01\xC3", 3}.get_string_view ());
+	REQUIRE_THROWS (decode (bytes.substr (0, bytes.size () - 1)));
+	REQUIRE_THROWS (decode (bytes + '\0'));
+}
+
+TEST_CASE ("snapshot") {
+	std::vector<int> squares;
+	var table = MAP ();
+	for (int i = 0; i < 200; ++i) {
+		squares.push_back (i * i);
+		table = set (std::move (table), ("key " + std::to_string (i)).c_str (), i);
+	}
+	var value = MAP ("squares", squares, "table", table, "name", "a string longer than 8 bytes", "pi", 3.25,
+					 "nul", immediate<Basic::String_View> {"a\0b", 3});
+	REQUIRE (IO::write_snapshot (IO::fopen ("test.snapshot", "wb"), value));
+
+	var root = IO::open_snapshot ("test.snapshot");
+	REQUIRE (dynamic_cast<const Mapped::Map*> (root.operator-> ()));
+	REQUIRE (count (root) == 5);
+	REQUIRE (root == value);
+	REQUIRE (value == root);
+	REQUIRE (hash (root) == hash (value));
+	REQUIRE (root ("pi") == 3.25);
+	REQUIRE (raw_cstring_length (root ("nul")) == 3);
+	REQUIRE (root ("nul") == immediate<Basic::String_View> {"a\0b", 3});
+	REQUIRE (root ("name") == "a string longer than 8 bytes");
+	REQUIRE_THROWS (root ("missing"));
+
+	var mapped_squares = root ("squares");
+	REQUIRE (count (mapped_squares) == 200);
+	REQUIRE (mapped_squares (0) == 0);
+	REQUIRE (mapped_squares (137) == 137 * 137);
+	REQUIRE (nth (mapped_squares, 199) == 199 * 199);
+	REQUIRE_FALSE (contains (mapped_squares, 200));
+	int64_t sum = 0;
+	for (auto enumerator = enumerate (mapped_squares); !enumerator.empty (); enumerator.next ())
+		sum += enumerator.read ().get_int ();
+	REQUIRE (sum == 2646700);
+
+	var mapped_table = root ("table");
+	REQUIRE (mapped_table ("key 150") == 150);
+	REQUIRE (get (mapped_table, "key 7", -1) == 7);
+	REQUIRE (get (mapped_table, "key 200", -1) == -1);
+	REQUIRE (mapped_table == table);
+	var table_again = root ("table");
+	REQUIRE (&obj_cast<const Mapped::Map&> (table_again).get_key_index () ==
+			 &obj_cast<const Mapped::Map&> (mapped_table).get_key_index ());
+	REQUIRE (&obj_cast<const Mapped::Vector&> (root ("squares")).get_item_index () ==
+			 &obj_cast<const Mapped::Vector&> (mapped_squares).get_item_index ());
+	table_again = nullptr;
+
+	var name = root ("name");
+	root = nullptr;
+	mapped_table = nullptr;
+	REQUIRE (name == "a string longer than 8 bytes");
+	REQUIRE (to_string (mapped_squares) == to_string (squares));
+	// The file must not change while values from it are alive.
+	name = nullptr;
+	mapped_squares = nullptr;
+
+	var deep = nullptr;
+	for (intptr_t i = 0; i <= binary::max_depth; ++i) deep = VEC (deep);
+	REQUIRE (IO::write_snapshot (IO::fopen ("test.snapshot", "wb"), deep));
+	var node = IO::open_snapshot ("test.snapshot");
+	for (intptr_t i = 1; i < binary::max_depth; ++i) node = node (0);
+	REQUIRE_THROWS (node (0));
+	node = nullptr;
+
+	IO::print_to (IO::fopen ("test.snapshot", "w"), "not a snapshot");
+	REQUIRE_THROWS (IO::open_snapshot ("test.snapshot"));
+	REQUIRE (std::remove ("test.snapshot") == 0);
+	REQUIRE_THROWS (IO::open_snapshot ("test.snapshot"));
+}
+
 TEST_CASE ("Readme") {
 	#if !defined (PURE_COMPILER_MSVC)
 	SECTION ("Sets") {
@@ -0,0 +1,85 @@
+#include <pure/core.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pure;
+
+// Reference implementation, which decodes every code point before comparing it.
+static int decoding_compare (const char* lhs, const char* rhs) {
+	for (;;) {
+		auto c1 = utf8::read_char_and_advance (lhs);
+		auto c2 = utf8::read_char_and_advance (rhs);
+		if (c1 != c2) return c1 < c2 ? -1 : 1;
+		if (c1 == 0) return 0;
+	}
+}
+
+template<typename Less>
+static double time_sort (std::vector<var> values, Less less) {
+	auto start = std::chrono::steady_clock::now ();
+	std::sort (values.begin (), values.end (), less);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now () - start;
+	return elapsed.count ();
+}
+
+template<typename Sort>
+static double time_pure (const std::vector<var>& values, Sort sort) {
+	auto start = std::chrono::steady_clock::now ();
+	auto sorted = sort (values);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now () - start;
+	return elapsed.count ();
+}
+
+int main (int argc, char** argv) {
+	intptr_t num_strings = argc > 1 ? std::atol (argv[1]) : 1000000;
+
+	// Mostly ascii keys with a shared prefix and a few multi-byte code points mixed in.
+	std::mt19937 rng {42};
+	const char* alphabet[] = {"a", "b", "c", "d", "e", "f", "g", "h", u8"\U000000D8", u8"\U000020AC", u8"\U0001F600"};
+	std::uniform_int_distribution<int> letter {0, 10};
+	std::uniform_int_distribution<int> length {4, 40};
+
+	std::vector<var> values;
+	values.reserve (num_strings);
+	for (intptr_t i = 0; i < num_strings; ++i) {
+		std::string s = "key/";
+		for (int n = length (rng); n > 0; --n) s += alphabet[letter (rng)];
+		values.emplace_back (s.c_str ());
+	}
+
+	auto decoding_ms = time_sort (values, [] (const var& lhs, const var& rhs) {
+		return decoding_compare (pure::raw_cstring (lhs), pure::raw_cstring (rhs)) < 0;
+	});
+	auto bytewise_ms = time_sort (values, [] (const var& lhs, const var& rhs) {
+		return utf8::string_compare (pure::raw_cstring (lhs), pure::raw_cstring (rhs)) < 0;
+	});
+	auto compare_ms = time_sort (values, [] (const var& lhs, const var& rhs) {
+		return pure::compare (lhs, rhs) < 0;
+	});
+
+	std::vector<var> ints;
+	ints.reserve (num_strings);
+	for (intptr_t i = 0; i < num_strings; ++i) ints.emplace_back (intptr_t (rng ()) - intptr_t (rng ()));
+	auto ints_compare_ms = time_sort (ints, [] (const var& lhs, const var& rhs) {
+		return pure::compare (lhs, rhs) < 0;
+	});
+
+	std::printf ("sorting %ld strings\n", long (num_strings));
+	std::printf ("  decoding compare:     %8.1f ms\n", decoding_ms);
+	std::printf ("  utf8::string_compare: %8.1f ms\n", bytewise_ms);
+	std::printf ("  pure::compare:        %8.1f ms\n", compare_ms);
+	std::printf ("  pure::sort:           %8.1f ms\n", time_pure (values, [] (const auto& v) { return sort (v); }));
+	std::printf ("  pure::parallel_sort:  %8.1f ms\n",
+				 time_pure (values, [] (const auto& v) { return parallel_sort (v); }));
+	std::printf ("sorting %ld integers\n", long (num_strings));
+	std::printf ("  pure::compare:        %8.1f ms\n", ints_compare_ms);
+	std::printf ("  pure::sort:           %8.1f ms\n", time_pure (ints, [] (const auto& v) { return sort (v); }));
+	std::printf ("  pure::parallel_sort:  %8.1f ms\n",
+				 time_pure (ints, [] (const auto& v) { return parallel_sort (v); }));
+	return 0;
+}
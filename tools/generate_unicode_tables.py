@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Generates include/pure/support/unicode_tables.hpp from the Unicode character database bundled with Python's
+unicodedata module. Run from the repository root:
+
+    python3 tools/generate_unicode_tables.py > include/pure/support/unicode_tables.hpp
+"""
+
+import sys
+import unicodedata
+
+MAX_CODE_POINT = 0x10FFFF
+HANGUL_FIRST, HANGUL_LAST = 0xAC00, 0xD7A3
+
+
+def code_points ():
+	for cp in range (MAX_CODE_POINT + 1):
+		if 0xD800 <= cp <= 0xDFFF: continue
+		yield cp
+
+
+def case_tables (fn):
+	"""Splits a case mapping into delta ranges for 1:1 mappings and a list of 1:n special mappings."""
+	singles, specials = [], []
+	for cp in code_points ():
+		mapped = fn (chr (cp))
+		if mapped == chr (cp): continue
+		if len (mapped) == 1: singles.append ((cp, ord (mapped) - cp))
+		else: specials.append ((cp, [ord (c) for c in mapped]))
+
+	ranges = []
+	for cp, delta in singles:
+		if ranges:
+			first, last, d, stride = ranges[-1]
+			if d == delta:
+				if first == last and cp - last in (1, 2):
+					ranges[-1] = (first, cp, d, cp - last)
+					continue
+				if cp - last == stride:
+					ranges[-1] = (first, cp, d, stride)
+					continue
+		ranges.append ((cp, cp, delta, 1))
+	return ranges, specials
+
+
+def combining_class_ranges ():
+	ranges = []
+	for cp in code_points ():
+		ccc = unicodedata.combining (chr (cp))
+		if not ccc: continue
+		if ranges and ranges[-1][1] == cp - 1 and ranges[-1][2] == ccc:
+			ranges[-1] = (ranges[-1][0], cp, ccc)
+		else:
+			ranges.append ((cp, cp, ccc))
+	return ranges
+
+
+def canonical_decompositions ():
+	result = []
+	for cp in code_points ():
+		if HANGUL_FIRST <= cp <= HANGUL_LAST: continue
+		d = unicodedata.decomposition (chr (cp))
+		if not d or d.startswith ('<'): continue
+		parts = [int (x, 16) for x in d.split ()]
+		assert len (parts) <= 2
+		result.append ((cp, parts[0], parts[1] if len (parts) == 2 else 0))
+	return result
+
+
+def primary_compositions (decompositions):
+	result = []
+	for cp, first, second in decompositions:
+		if not second: continue
+		if unicodedata.normalize ('NFC', chr (first) + chr (second)) != chr (cp): continue
+		result.append ((first, second, cp))
+	return sorted (result)
+
+
+def hex_cp (cp):
+	return '0x%04X' % cp
+
+
+def emit_array (out, type_name, name, rows, per_line):
+	out.write ('\tinline constexpr %s %s[] = {\n' % (type_name, name))
+	for i in range (0, len (rows), per_line):
+		out.write ('\t\t' + ' '.join (r + ',' for r in rows[i:i + per_line]) + '\n')
+	out.write ('\t};\n\n')
+
+
+def main ():
+	out = sys.stdout
+	out.write ('#pragma once\n\n')
+	out.write ('// Generated by tools/generate_unicode_tables.py from Unicode %s. Do not edit.\n\n' %
+			   unicodedata.unidata_version)
+	out.write ('#include <cstdint>\n\n')
+	out.write ('namespace pure::unicode::tables {\n')
+	out.write ('\tstruct case_range { char32_t first; char32_t last; int32_t delta; int32_t stride; };\n')
+	out.write ('\tstruct special_case { char32_t code_point; char32_t mapping[3]; };\n')
+	out.write ('\tstruct class_range { char32_t first; char32_t last; uint8_t combining_class; };\n')
+	out.write ('\tstruct decomposition { char32_t code_point; char32_t first; char32_t second; };\n')
+	out.write ('\tstruct composition { char32_t first; char32_t second; char32_t composite; };\n\n')
+
+	for name, fn in (('lower', str.lower), ('upper', str.upper), ('fold', str.casefold)):
+		ranges, specials = case_tables (fn)
+		emit_array (out, 'case_range', name + '_ranges',
+					['{%s, %s, %d, %d}' % (hex_cp (f), hex_cp (l), d, s) for f, l, d, s in ranges], 3)
+		emit_array (out, 'special_case', name + '_specials',
+					['{%s, {%s}}' % (hex_cp (cp), ', '.join (hex_cp (c) for c in (m + [0, 0])[:3]))
+					 for cp, m in specials], 2)
+
+	emit_array (out, 'class_range', 'combining_classes',
+				['{%s, %s, %d}' % (hex_cp (f), hex_cp (l), c) for f, l, c in combining_class_ranges ()], 4)
+
+	decompositions = canonical_decompositions ()
+	emit_array (out, 'decomposition', 'decompositions',
+				['{%s, %s, %s}' % tuple (hex_cp (x) for x in d) for d in decompositions], 4)
+	emit_array (out, 'composition', 'compositions',
+				['{%s, %s, %s}' % tuple (hex_cp (x) for x in c) for c in primary_compositions (decompositions)], 4)
+	out.write ('}\n')
+
+
+if __name__ == '__main__':
+	main ()